@@ -1,18 +1,50 @@
 #include "Automaton.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
 #include <iostream>
+#include <limits>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <stack>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FA_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define FA_SIMD_X86 0
+#endif
+#include <deque>
+#include <utility>
+
 namespace fa {
 
-  Automaton::Automaton() {
-    this->symbols = {};
-    this->states = {};
+  Automaton::Automaton()
+  : Automaton(std::pmr::get_default_resource()) {
+  }
+
+  Automaton::Automaton(std::pmr::memory_resource* resource)
+  : states(resource), symbols(resource) {
+  }
+
+  Automaton::Automaton(const Automaton& other)
+  : states(other.states, other.getMemoryResource()), symbols(other.symbols, other.getMemoryResource()) {
+  }
+
+  std::pmr::memory_resource* Automaton::getMemoryResource() const {
+    return states.get_allocator().resource();
   }
 
   bool Automaton::isValid() const {
@@ -58,15 +90,11 @@ namespace fa {
       return false;
     }
 
-    State st;
-    st.state = state;
-    st.isFinal = false;
-    st.isInitial = false;
-    st.transitions = {};
-
-    if(!states.insert(std::pair<int, State>(state, st)).second) {
+    auto inserted = states.try_emplace(state);
+    if (!inserted.second) {
       return false;
-    };
+    }
+    inserted.first->second.state = state;
     return true;
   }
 
@@ -250,7 +278,7 @@ namespace fa {
 
     for (auto it : origin) {
       if (hasState(it) && states.find(it)->second.transitions.find(alpha) != states.find(it)->second.transitions.end()) {
-        std::set<int> arrival_states = states.find(it)->second.transitions.find(alpha)->second;
+        const std::pmr::set<int>& arrival_states = states.find(it)->second.transitions.find(alpha)->second;
         for (const int it2 : arrival_states) {
           result.insert(it2);
         }
@@ -260,6 +288,23 @@ namespace fa {
     return result;
   }
 
+  std::pmr::set<int> Automaton::makeTransition(const std::pmr::set<int>& origin, char alpha, std::pmr::memory_resource* resource) const {
+    std::pmr::set<int> result(resource);
+
+    for (int it : origin) {
+      auto state = states.find(it);
+      if (state == states.end()) {
+        continue;
+      }
+      auto arrival_states = state->second.transitions.find(alpha);
+      if (arrival_states != state->second.transitions.end()) {
+        result.insert(arrival_states->second.begin(), arrival_states->second.end());
+      }
+    }
+
+    return result;
+  }
+
   std::set<int> Automaton::readString(const std::string& word) const {
     // The returned set is the set of states gone through to read the word
     std::set<int> result;
@@ -379,8 +424,7 @@ namespace fa {
   }
 
   bool Automaton::hasEmptyIntersectionWith(const Automaton& other) const {
-    Automaton intersection = createIntersection(*this, other);
-    return intersection.isLanguageEmpty();
+    return !exploreProduct({ this, &other }, nullptr);
   }
 
   bool Automaton::isIncludedIn(const Automaton& other) const {
@@ -392,55 +436,199 @@ namespace fa {
         return false;
       }
     }
-    Automaton complement = other;
-    // complement = createDeterministic(complement);
-    complement = createComplement(complement);
-    return hasEmptyIntersectionWith(complement);
+    return hasEmptyIntersectionWith(createComplement(other));
   }
 
 
 
-  Automaton Automaton::createMirror(const Automaton& automaton) {
-    fa::Automaton mirror;
+  namespace {
+
+    /**
+     * A node of a breadth-first search, with the node and the symbol it was discovered from
+     */
+    struct SearchNode {
+      std::size_t parent;
+      char symbol;
+    };
+
+    /**
+     * Rebuild the word leading to a node, the roots are their own parent
+     */
+    std::string rebuildWord(const std::vector<SearchNode>& nodes, std::size_t node) {
+      std::string word;
+      while (nodes[node].parent != node) {
+        word.push_back(nodes[node].symbol);
+        node = nodes[node].parent;
+      }
+      std::reverse(word.begin(), word.end());
+      return word;
+    }
 
-    // Add the states to mirror and invert the states
-    for (auto& state : automaton.states) {
-      mirror.addState(state.first);
+  }
+
+  std::optional<std::string> Automaton::shortestWord() const {
+    std::vector<SearchNode> nodes;
+    std::vector<int> found;
+    std::unordered_map<int, std::size_t> indices;
+    for (const auto& state : states) {
       if (state.second.isInitial) {
-        mirror.setStateFinal(state.first);
+        indices.emplace(state.first, nodes.size());
+        nodes.push_back({ nodes.size(), fa::Epsilon });
+        found.push_back(state.first);
       }
-      if (state.second.isFinal) {
-        mirror.setStateInitial(state.first);
+    }
+
+    // The nodes are discovered by increasing length of their words
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+      const State& state = states.at(found[node]);
+      if (state.isFinal) {
+        return rebuildWord(nodes, node);
+      }
+      for (const auto& symbol : state.transitions) {
+        if (symbol.first == fa::Epsilon) {
+          continue;
+        }
+        for (const int target : symbol.second) {
+          if (indices.emplace(target, nodes.size()).second) {
+            nodes.push_back({ node, symbol.first });
+            found.push_back(target);
+          }
+        }
       }
     }
+    return std::nullopt;
+  }
 
-    // Add the symbols to mirror
-    for (auto& symbol : automaton.symbols) {
-      mirror.addSymbol(symbol);
+  std::optional<std::string> Automaton::findCommonWord(const Automaton& other) const {
+    std::vector<SearchNode> nodes;
+    std::vector<std::pair<int, int>> found;
+    std::map<std::pair<int, int>, std::size_t> indices;
+    std::vector<int> initials;
+    for (const auto& state : other.states) {
+      if (state.second.isInitial) {
+        initials.push_back(state.first);
+      }
+    }
+    for (const auto& state : states) {
+      if (!state.second.isInitial) {
+        continue;
+      }
+      for (const int initial : initials) {
+        indices.emplace(std::make_pair(state.first, initial), nodes.size());
+        nodes.push_back({ nodes.size(), fa::Epsilon });
+        found.emplace_back(state.first, initial);
+      }
     }
 
-    // Add the transitions to mirror
-    for (auto& state : automaton.states) {
-      for (auto& symbol : state.second.transitions) {
-        for (auto& state2 : symbol.second) {
-          mirror.addTransition(state2, symbol.first, state.first);
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+      const State& lhs = states.at(found[node].first);
+      const State& rhs = other.states.at(found[node].second);
+      if (lhs.isFinal && rhs.isFinal) {
+        return rebuildWord(nodes, node);
+      }
+      for (const auto& symbol : lhs.transitions) {
+        const auto targets = rhs.transitions.find(symbol.first);
+        if (symbol.first == fa::Epsilon || targets == rhs.transitions.end()) {
+          continue;
+        }
+        for (const int lhsTarget : symbol.second) {
+          for (const int rhsTarget : targets->second) {
+            if (indices.emplace(std::make_pair(lhsTarget, rhsTarget), nodes.size()).second) {
+              nodes.push_back({ node, symbol.first });
+              found.emplace_back(lhsTarget, rhsTarget);
+            }
+          }
         }
       }
     }
-    return mirror;
+    return std::nullopt;
   }
 
-  Automaton Automaton::createComplete(const Automaton& automaton) {
-    if (automaton.isComplete()) {
-      return automaton;
+  std::optional<std::string> Automaton::findNotIncludedWord(const Automaton& other) const {
+    using Pair = std::pair<int, std::vector<int>>;
+    std::vector<SearchNode> nodes;
+    std::vector<Pair> found;
+    std::map<Pair, std::size_t> indices;
+
+    std::vector<int> initials;
+    for (const auto& state : other.states) {
+      if (state.second.isInitial) {
+        initials.push_back(state.first);
+      }
+    }
+    for (const auto& state : states) {
+      if (state.second.isInitial) {
+        indices.emplace(Pair(state.first, initials), nodes.size());
+        nodes.push_back({ nodes.size(), fa::Epsilon });
+        found.emplace_back(state.first, initials);
+      }
+    }
+
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+      const State& state = states.at(found[node].first);
+      if (state.isFinal && std::none_of(found[node].second.begin(), found[node].second.end(), [&other](int subsetState) {
+        return other.states.at(subsetState).isFinal;
+      })) {
+        return rebuildWord(nodes, node);
+      }
+      for (const auto& symbol : state.transitions) {
+        if (symbol.first == fa::Epsilon) {
+          continue;
+        }
+        // The subset is kept sorted, so that equal subsets are found in the map
+        std::vector<int> subset;
+        for (const int subsetState : found[node].second) {
+          const auto& transitions = other.states.at(subsetState).transitions;
+          const auto targets = transitions.find(symbol.first);
+          if (targets != transitions.end()) {
+            subset.insert(subset.end(), targets->second.begin(), targets->second.end());
+          }
+        }
+        std::sort(subset.begin(), subset.end());
+        subset.erase(std::unique(subset.begin(), subset.end()), subset.end());
+        for (const int target : symbol.second) {
+          if (indices.emplace(Pair(target, subset), nodes.size()).second) {
+            nodes.push_back({ node, symbol.first });
+            found.emplace_back(target, subset);
+          }
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+  void Automaton::mirrorInPlace() {
+    // Detach every transition map, then move each transition node to its new origin
+    std::vector<std::pair<int, Transitions>> detached;
+    detached.reserve(states.size());
+    for (auto& state : states) {
+      detached.emplace_back(state.first, std::move(state.second.transitions));
+      state.second.transitions.clear();
+      std::swap(state.second.isInitial, state.second.isFinal);
     }
 
-    fa::Automaton complete = automaton;
+    for (auto& origin : detached) {
+      for (auto& symbol : origin.second) {
+        std::pmr::set<int>& arrivals = symbol.second;
+        while (!arrivals.empty()) {
+          auto node = arrivals.extract(arrivals.begin());
+          int arrival = node.value();
+          node.value() = origin.first;
+          states.find(arrival)->second.transitions[symbol.first].insert(std::move(node));
+        }
+      }
+    }
+  }
+
+  void Automaton::complete() {
+    if (isComplete()) {
+      return;
+    }
 
     int sinkState = -1;
 
     // Attempt to find a sink state in the automaton
-    for (const auto& state : automaton.states) {
+    for (const auto& state : states) {
       // sink state has been found in condition that it has no exiting transitions
       if (!state.second.isFinal) {
         if (state.second.transitions.empty()) {
@@ -462,40 +650,163 @@ namespace fa {
 
     if (sinkState == -1) {
       // creation of the sink state
-      sinkState = static_cast<int>(automaton.countStates()) + 1;
-      while(complete.hasState(sinkState)) {
+      sinkState = static_cast<int>(countStates()) + 1;
+      while(hasState(sinkState)) {
         ++sinkState;
       }
     }
     // Adding missing transitions to self to make automaton complete
-    complete.addState(sinkState);
-    for (const char symbol : automaton.symbols) {
-      complete.addTransition(sinkState, symbol, sinkState);
+    addState(sinkState);
+    for (const char symbol : symbols) {
+      addTransition(sinkState, symbol, sinkState);
     }
 
 
-    for (auto& state : complete.states) {
-      if (state.second.transitions.size() != complete.symbols.size()) {
-        for (auto& symbol : complete.symbols) {
+    for (auto& state : states) {
+      if (state.second.transitions.size() != symbols.size()) {
+        for (auto& symbol : symbols) {
           if (state.second.transitions.find(symbol) == state.second.transitions.end()) {
-            complete.addTransition(state.first, symbol, sinkState);
+            addTransition(state.first, symbol, sinkState);
           }
         }
       }
     }
-    return complete;
   }
 
-  Automaton Automaton::createComplement(const Automaton& automaton) {
-    Automaton complement = automaton;
-    if (!complement.isDeterministic()) { complement = createDeterministic(complement); }
-    if (!complement.isComplete()) { complement = createComplete(complement); }
+  void Automaton::complementInPlace() {
+    if (!isDeterministic()) {
+      *this = createDeterministic(*this);
+    }
+    complete();
+
+    for (auto& state : states) {
+      state.second.isFinal = !state.second.isFinal;
+    }
+  }
+
+
+
+  Automaton Automaton::createMirror(const Automaton& automaton) {
+    return createMirror(Automaton(automaton));
+  }
+
+  std::unordered_map<int, int> Automaton::appendRenumbered(const Automaton& other, int first) {
+    symbols.insert(other.symbols.begin(), other.symbols.end());
+
+    std::unordered_map<int, int> numbers;
+    numbers.reserve(other.states.size());
+    int number = first;
+    for (const auto& state : other.states) {
+      numbers.emplace(state.first, number++);
+    }
+
+    // The new numbers are increasing, so each state is inserted at the end of the map
+    for (const auto& state : other.states) {
+      State copy(states.get_allocator());
+      copy.state = numbers.at(state.first);
+      copy.isInitial = state.second.isInitial;
+      copy.isFinal = state.second.isFinal;
+      for (const auto& symbol : state.second.transitions) {
+        if (symbol.first == fa::Epsilon) {
+          continue;
+        }
+        std::pmr::set<int>& targets = copy.transitions[symbol.first];
+        for (const int target : symbol.second) {
+          targets.insert(numbers.at(target));
+        }
+      }
+      states.emplace_hint(states.end(), copy.state, std::move(copy));
+    }
+    return numbers;
+  }
+
+  Automaton::Transitions Automaton::collectInitialTransitions(const Automaton& other, const std::unordered_map<int, int>& numbers) const {
+    Transitions transitions(states.get_allocator());
+    for (const auto& state : other.states) {
+      if (!state.second.isInitial) {
+        continue;
+      }
+      for (const auto& symbol : states.at(numbers.at(state.first)).transitions) {
+        transitions[symbol.first].insert(symbol.second.begin(), symbol.second.end());
+      }
+    }
+    return transitions;
+  }
+
+  Automaton Automaton::createUnion(const Automaton& lhs, const Automaton& rhs) {
+    Automaton result(lhs.getMemoryResource());
+    result.appendRenumbered(lhs, 0);
+    result.appendRenumbered(rhs, static_cast<int>(lhs.states.size()));
+    return result;
+  }
+
+  Automaton Automaton::createConcatenation(const Automaton& lhs, const Automaton& rhs) {
+    Automaton result(lhs.getMemoryResource());
+    const std::unordered_map<int, int> lhsNumbers = result.appendRenumbered(lhs, 0);
+    const std::unordered_map<int, int> rhsNumbers = result.appendRenumbered(rhs, static_cast<int>(lhs.states.size()));
+    const Transitions starts = result.collectInitialTransitions(rhs, rhsNumbers);
+
+    bool acceptsEmpty = false;
+    for (const auto& state : rhs.states) {
+      if (state.second.isInitial) {
+        acceptsEmpty = acceptsEmpty || state.second.isFinal;
+        result.states.at(rhsNumbers.at(state.first)).isInitial = false;
+      }
+    }
+
+    for (const auto& state : lhs.states) {
+      if (!state.second.isFinal) {
+        continue;
+      }
+      State& copy = result.states.at(lhsNumbers.at(state.first));
+      copy.isFinal = acceptsEmpty;
+      for (const auto& symbol : starts) {
+        copy.transitions[symbol.first].insert(symbol.second.begin(), symbol.second.end());
+      }
+    }
+    return result;
+  }
+
+  Automaton Automaton::createKleeneStar(const Automaton& automaton) {
+    Automaton result(automaton.getMemoryResource());
+    result.addState(0);
+    const std::unordered_map<int, int> numbers = result.appendRenumbered(automaton, 1);
+    const Transitions starts = result.collectInitialTransitions(automaton, numbers);
 
-    for (const auto& state : complement.states) {
-      complement.states.at(state.first).isFinal = !complement.states.at(state.first).isFinal;
+    for (auto& state : result.states) {
+      if (state.first == 0 || state.second.isFinal) {
+        for (const auto& symbol : starts) {
+          state.second.transitions[symbol.first].insert(symbol.second.begin(), symbol.second.end());
+        }
+      }
+      state.second.isInitial = false;
     }
+    result.setStateInitial(0);
+    result.setStateFinal(0);
+    return result;
+  }
+
+  Automaton Automaton::createMirror(Automaton&& automaton) {
+    automaton.mirrorInPlace();
+    return std::move(automaton);
+  }
+
+  Automaton Automaton::createComplete(const Automaton& automaton) {
+    return createComplete(Automaton(automaton));
+  }
+
+  Automaton Automaton::createComplete(Automaton&& automaton) {
+    automaton.complete();
+    return std::move(automaton);
+  }
+
+  Automaton Automaton::createComplement(const Automaton& automaton) {
+    return createComplement(Automaton(automaton));
+  }
 
-    return complement;
+  Automaton Automaton::createComplement(Automaton&& automaton) {
+    automaton.complementInPlace();
+    return std::move(automaton);
   }
 
 
@@ -503,7 +814,7 @@ namespace fa {
   Automaton Automaton::createIntersection(const Automaton& lhs, const Automaton& rhs) {
     // the goal is to go through both automats at the same time synchronously
     // the challenge is to find a way of saving the visited states into a pair -> map of pairs
-    Automaton intersection;
+    Automaton intersection(lhs.getMemoryResource());
 
     // Symbols
     std::unordered_set<char> shared_symbols;
@@ -531,8 +842,10 @@ namespace fa {
 
     // States
 
-    std::map<std::pair<int, int>, int> pairs;
-    std::queue<std::pair<int, int>> queue;
+    // Every temporary structure is released at once with the pool
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::map<std::pair<int, int>, int> pairs(&pool);
+    std::queue<std::pair<int, int>, std::pmr::deque<std::pair<int, int>>> queue{std::pmr::deque<std::pair<int, int>>(&pool)};
     int stateID = 0;
 
     // going through both automats to find the initial pairs
@@ -576,11 +889,15 @@ namespace fa {
       auto statePair = queue.front();
       queue.pop();
       int currentStateID = pairs[statePair];
+      std::pmr::set<int> l_origin(&pool);
+      l_origin.insert(statePair.first);
+      std::pmr::set<int> r_origin(&pool);
+      r_origin.insert(statePair.second);
 
       // Go through the common symbols
       for (char symbol : intersection.symbols) {
-        std::set<int> l_states = lhs.makeTransition({statePair.first}, symbol);
-        std::set<int> r_states = rhs.makeTransition({statePair.second}, symbol);
+        std::pmr::set<int> l_states = lhs.makeTransition(l_origin, symbol, &pool);
+        std::pmr::set<int> r_states = rhs.makeTransition(r_origin, symbol, &pool);
 
         // Like above, create the pairs with what is obtained
         for (int l_state : l_states) {
@@ -609,7 +926,7 @@ namespace fa {
   }
 
   Automaton Automaton::createDeterministic(const Automaton& other) {
-    Automaton deterministic;
+    Automaton deterministic(other.getMemoryResource());
 
     for (const char symbol : other.symbols) {
       deterministic.addSymbol(symbol);
@@ -621,11 +938,13 @@ namespace fa {
       return deterministic;
     }
 
-    std::map<std::set<int>, int> det_states;
+    // Every temporary structure is released at once with the pool
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::map<std::pmr::set<int>, int> det_states(&pool);
     int state_ID = 0;
-    std::queue<std::set<int>> queue;
+    std::queue<std::pmr::set<int>, std::pmr::deque<std::pmr::set<int>>> queue{std::pmr::deque<std::pmr::set<int>>(&pool)};
 
-    std::set<int> initials;
+    std::pmr::set<int> initials(&pool);
     // Add the initial states into the states to add
     for (const auto& state : other.states) {
       if (state.second.isInitial) {
@@ -638,12 +957,12 @@ namespace fa {
     deterministic.setStateInitial(det_states[initials]);
 
     while (!queue.empty()) {
-      auto current_set = queue.front();
+      std::pmr::set<int> current_set = std::move(queue.front());
       queue.pop();
 
       for (char symbol : other.symbols) {
         // Find the next states from the current ones
-        std::set<int> next_set = other.makeTransition(current_set, symbol);
+        std::pmr::set<int> next_set = other.makeTransition(current_set, symbol, &pool);
         // There are no transitions with this symbol
         if (next_set.empty()) {
           continue;
@@ -674,16 +993,250 @@ namespace fa {
     return deterministic;
   }
 
+  Automaton Automaton::createDeterministic(Automaton&& other) {
+    // Same normalized result as the const& overload, even for a deterministic input
+    return createDeterministic(other);
+  }
+
+  namespace {
+
+    unsigned resolveThreadCount(unsigned threads) {
+      if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+      }
+      return threads == 0 ? 1 : threads;
+    }
+
+    using Subset = std::vector<std::uint32_t>;
+
+    struct SubsetHash {
+      std::size_t operator()(const Subset& subset) const {
+        std::size_t hash = 14695981039346656037ull;
+        for (std::uint32_t state : subset) {
+          hash = (hash ^ state) * 1099511628211ull;
+        }
+        return hash;
+      }
+    };
+
+    /**
+     * Table of the subsets, split in shards each protected by its own mutex
+     *
+     * The keys of an unordered_map never move, so a pointer to a subset stays
+     * valid while other threads insert new subsets.
+     */
+    class ConcurrentSubsetTable {
+    public:
+      static constexpr std::size_t ShardCount = 64;
+
+      /**
+       * Find the ID of a subset, or give it a new one
+       *
+       * Returns the ID, the stored subset, and whether the subset is new.
+       */
+      std::tuple<std::uint32_t, const Subset*, bool> insert(Subset&& subset) {
+        const std::size_t hash = SubsetHash()(subset);
+        Shard& shard = shards[hash % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.ids.find(subset);
+        if (found != shard.ids.end()) {
+          return { found->second, &found->first, false };
+        }
+        auto inserted = shard.ids.emplace(std::move(subset), nextID++);
+        return { inserted.first->second, &inserted.first->first, true };
+      }
+
+      std::uint32_t size() const {
+        return nextID;
+      }
+
+    private:
+      struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Subset, std::uint32_t, SubsetHash> ids;
+      };
+
+      std::array<Shard, ShardCount> shards;
+      std::atomic<std::uint32_t> nextID{0};
+    };
+
+  }
+
+  Automaton Automaton::createDeterministic(const Automaton& other, unsigned threads) {
+    threads = resolveThreadCount(threads);
+    if (threads == 1 || other.isLanguageEmpty()) {
+      return createDeterministic(other);
+    }
+
+    // Flat copy of the automaton: successors[index * symbolCount + symbol] is sorted
+    const std::vector<char> symbols(other.symbols.begin(), other.symbols.end());
+    const std::size_t symbolCount = symbols.size();
+    std::unordered_map<int, std::uint32_t> indices;
+    std::vector<std::uint8_t> finals;
+    for (const auto& state : other.states) {
+      indices[state.first] = static_cast<std::uint32_t>(finals.size());
+      finals.push_back(state.second.isFinal ? 1 : 0);
+    }
+    std::vector<std::vector<std::uint32_t>> successors(finals.size() * symbolCount);
+    Subset initials;
+    for (const auto& state : other.states) {
+      const std::uint32_t index = indices[state.first];
+      if (state.second.isInitial) {
+        initials.push_back(index);
+      }
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        auto arrivals = state.second.transitions.find(symbols[symbol]);
+        if (arrivals != state.second.transitions.end()) {
+          for (int arrival : arrivals->second) {
+            successors[index * symbolCount + symbol].push_back(indices[arrival]);
+          }
+          std::sort(successors[index * symbolCount + symbol].begin(), successors[index * symbolCount + symbol].end());
+        }
+      }
+    }
+    std::sort(initials.begin(), initials.end());
+
+    // A row of the result: its provisional ID, its finality and one target per symbol
+    constexpr std::uint32_t None = std::numeric_limits<std::uint32_t>::max();
+    struct Row {
+      std::uint32_t id;
+      bool isFinal;
+      std::vector<std::uint32_t> targets;
+    };
+
+    ConcurrentSubsetTable table;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::pair<std::uint32_t, const Subset*>> frontier;
+    std::size_t active = 0;
+
+    auto initial = table.insert(std::move(initials));
+    frontier.emplace_back(std::get<0>(initial), std::get<1>(initial));
+
+    std::vector<std::vector<Row>> results(threads);
+    auto worker = [&](std::vector<Row>& rows) {
+      Subset next;
+      std::vector<std::pair<std::uint32_t, const Subset*>> discovered;
+      for (;;) {
+        std::pair<std::uint32_t, const Subset*> current;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          available.wait(lock, [&] { return !frontier.empty() || active == 0; });
+          if (frontier.empty()) {
+            return;
+          }
+          current = frontier.back();
+          frontier.pop_back();
+          ++active;
+        }
+
+        Row row{ current.first, false, std::vector<std::uint32_t>(symbolCount, None) };
+        for (std::uint32_t state : *current.second) {
+          row.isFinal = row.isFinal || finals[state];
+        }
+        for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+          next.clear();
+          for (std::uint32_t state : *current.second) {
+            const auto& arrivals = successors[state * symbolCount + symbol];
+            next.insert(next.end(), arrivals.begin(), arrivals.end());
+          }
+          if (next.empty()) {
+            continue;
+          }
+          std::sort(next.begin(), next.end());
+          next.erase(std::unique(next.begin(), next.end()), next.end());
+
+          auto inserted = table.insert(Subset(next));
+          row.targets[symbol] = std::get<0>(inserted);
+          if (std::get<2>(inserted)) {
+            discovered.emplace_back(std::get<0>(inserted), std::get<1>(inserted));
+          }
+        }
+        rows.push_back(std::move(row));
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          frontier.insert(frontier.end(), discovered.begin(), discovered.end());
+          --active;
+        }
+        discovered.clear();
+        available.notify_all();
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+      pool.emplace_back(worker, std::ref(results[i]));
+    }
+    worker(results[0]);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+
+    // Gather the rows by provisional ID
+    std::vector<Row> rows(table.size());
+    for (auto& result : results) {
+      for (auto& row : result) {
+        rows[row.id] = std::move(row);
+      }
+    }
+
+    // Canonical renumbering: breadth-first order from the initial subset, as in the sequential version
+    std::vector<std::uint32_t> numbers(rows.size(), None);
+    std::vector<std::uint32_t> order;
+    numbers[std::get<0>(initial)] = 0;
+    order.push_back(std::get<0>(initial));
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      for (std::uint32_t target : rows[order[i]].targets) {
+        if (target != None && numbers[target] == None) {
+          numbers[target] = static_cast<std::uint32_t>(order.size());
+          order.push_back(target);
+        }
+      }
+    }
+
+    Automaton deterministic(other.getMemoryResource());
+    for (const char symbol : symbols) {
+      deterministic.addSymbol(symbol);
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      deterministic.addState(static_cast<int>(i));
+      if (rows[order[i]].isFinal) {
+        deterministic.setStateFinal(static_cast<int>(i));
+      }
+    }
+    deterministic.setStateInitial(0);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      const Row& row = rows[order[i]];
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        if (row.targets[symbol] != None) {
+          deterministic.addTransition(static_cast<int>(i), symbols[symbol], static_cast<int>(numbers[row.targets[symbol]]));
+        }
+      }
+    }
+
+    return deterministic;
+  }
+
 
 
   Automaton Automaton::createMinimalMoore(const Automaton& other) {
-    Automaton CD = other;
+    return createMinimalMoore(Automaton(other));
+  }
+
+  Automaton Automaton::createMinimalMoore(Automaton&& other) {
+    Automaton CD = std::move(other);
     CD.removeNonAccessibleStates();
-    CD = createDeterministic(CD);
-    CD = createComplete(CD);
+    if (!CD.isDeterministic()) {
+      CD = createDeterministic(CD);
+    }
+    CD.complete();
+
+    // Every temporary structure is released at once with the pool
+    std::pmr::unsynchronized_pool_resource pool;
 
     // Create initial partition (final : class 1, other : class 0)
-    std::map<int, int> classes;
+    std::pmr::map<int, int> classes(&pool);
     for (auto& state : CD.states) {
       classes[state.first] = CD.isStateFinal(state.first) ? 1 : 0;
     }
@@ -692,12 +1245,12 @@ namespace fa {
 
     while (changed) {
       changed = false;
-      std::map<int, std::vector<int>> signatures;
-      std::map<std::vector<int>, int> classIDs;
+      std::pmr::map<int, std::pmr::vector<int>> signatures(&pool);
+      std::pmr::map<std::pmr::vector<int>, int> classIDs(&pool);
       int nextClassID = 0;
 
       for (auto& state : CD.states) {
-        std::vector<int> signature;
+        std::pmr::vector<int> signature(&pool);
 
         for (auto& symbol : state.second.transitions) { // possible because minimal is complete and deterministic
           int dest = *symbol.second.begin();
@@ -705,10 +1258,10 @@ namespace fa {
         }
 
         signature.push_back(CD.isStateFinal(state.first) ? 1 : 0);
-        signatures[state.first] = signature;
+        signatures[state.first] = std::move(signature);
       }
 
-      std::map<int, int> newClasses;
+      std::pmr::map<int, int> newClasses(&pool);
       for (auto& signature : signatures) {
         if (!classIDs.count(signature.second)) {
           classIDs[signature.second] = nextClassID++;
@@ -718,20 +1271,20 @@ namespace fa {
 
       // Check to see if new iteration is different from previous
       if (newClasses != classes) {
-        classes = newClasses;
+        classes = std::move(newClasses);
         changed = true;
       }
     }
 
-    Automaton minimal;
+    Automaton minimal(CD.getMemoryResource());
 
     // Add the symbols to new automat
-    for (char symbol : other.symbols) {
+    for (char symbol : CD.symbols) {
       minimal.addSymbol(symbol);
     }
 
     // Clean up the classes
-    std::map<int, int> newStates;
+    std::pmr::map<int, int> newStates(&pool);
     for (auto& state : classes) {
       if (!newStates.count(state.second)) {
         newStates[state.second] = state.first;
@@ -741,16 +1294,19 @@ namespace fa {
     // Create the new states
     for (auto& state : newStates) {
       minimal.addState(state.first);
-      // Check if the old state was initial
-      if (CD.isStateInitial(state.second)) {
-        minimal.setStateInitial(state.first);
-      }
       // Check if the old state was final
       if (CD.isStateFinal(state.second)) {
         minimal.setStateFinal(state.first);
       }
     }
 
+    // The initial state is not always the representative of its class
+    for (auto& state : CD.states) {
+      if (state.second.isInitial) {
+        minimal.setStateInitial(classes[state.first]);
+      }
+    }
+
     // Create the transitions
     for (auto& state_pairs : newStates) {
       State &s = minimal.states[state_pairs.first];
@@ -766,19 +1322,2913 @@ namespace fa {
     return minimal;
   }
 
-  Automaton Automaton::createMinimalBrzozowski(const Automaton& other) {
-    Automaton minimal = other;
-    minimal.removeNonAccessibleStates();
+  namespace {
 
-    minimal = createMirror(minimal);
-    minimal = createDeterministic(minimal);
+    /**
+     * Run a function on several threads, each one receiving its index
+     */
+    template<typename Function>
+    void runOnThreads(unsigned threads, Function function) {
+      std::vector<std::thread> pool;
+      for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(function, i);
+      }
+      function(0u);
+      for (auto& thread : pool) {
+        thread.join();
+      }
+    }
 
-    minimal = createMirror(minimal);
-    minimal = createDeterministic(minimal);
+  }
 
-    minimal = createComplete(minimal);
+  Automaton Automaton::createMinimalMoore(const Automaton& other, unsigned threads) {
+    threads = resolveThreadCount(threads);
 
-    return minimal;
-  }
-}
+    Automaton CD = other;
+    CD.removeNonAccessibleStates();
+    if (!CD.isDeterministic()) {
+      CD = createDeterministic(CD, threads);
+    }
+    CD.complete();
+
+    // Flat copy of the complete automaton: targets[index * symbolCount + symbol]
+    const std::size_t symbolCount = CD.symbols.size();
+    const std::size_t stateCount = CD.states.size();
+    std::unordered_map<int, std::uint32_t> indices;
+    std::vector<int> ids;
+    for (const auto& state : CD.states) {
+      indices[state.first] = static_cast<std::uint32_t>(ids.size());
+      ids.push_back(state.first);
+    }
+    std::vector<std::uint32_t> targets(stateCount * symbolCount);
+    std::vector<std::uint8_t> finals(stateCount);
+    std::vector<std::uint32_t> classes(stateCount);
+    for (const auto& state : CD.states) {
+      const std::uint32_t index = indices[state.first];
+      std::size_t symbol = 0;
+      for (const auto& transition : state.second.transitions) {
+        targets[index * symbolCount + symbol++] = indices[*transition.second.begin()];
+      }
+      finals[index] = state.second.isFinal ? 1 : 0;
+      // Create initial partition (final : class 1, other : class 0)
+      classes[index] = finals[index];
+    }
+
+    // A signature is the class of each target followed by the finality
+    const std::size_t width = symbolCount + 1;
+    std::vector<std::uint32_t> signatures(stateCount * width);
+    std::vector<std::size_t> hashes(stateCount);
+    std::vector<std::uint32_t> representatives(stateCount);
+    std::vector<std::uint32_t> newClasses(stateCount);
+    const std::size_t chunk = (stateCount + threads - 1) / threads;
+    // buckets[producer][owner] lists in increasing order the states of a chunk whose signature an owner handles
+    std::vector<std::vector<std::vector<std::uint32_t>>> buckets(threads, std::vector<std::vector<std::uint32_t>>(threads));
+
+    auto signatureHash = [&hashes](std::uint32_t state) {
+      return hashes[state];
+    };
+    auto sameSignature = [&signatures, width](std::uint32_t lhs, std::uint32_t rhs) {
+      return std::equal(signatures.begin() + lhs * width, signatures.begin() + (lhs + 1) * width, signatures.begin() + rhs * width);
+    };
+
+    bool changed = true;
+    while (changed) {
+      runOnThreads(threads, [&](unsigned thread) {
+        for (std::vector<std::uint32_t>& bucket : buckets[thread]) {
+          bucket.clear();
+        }
+        const std::size_t end = std::min(stateCount, (thread + 1) * chunk);
+        for (std::size_t state = thread * chunk; state < end; ++state) {
+          std::uint32_t* signature = &signatures[state * width];
+          std::size_t hash = 14695981039346656037ull;
+          for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+            signature[symbol] = classes[targets[state * symbolCount + symbol]];
+            hash = (hash ^ signature[symbol]) * 1099511628211ull;
+          }
+          signature[symbolCount] = finals[state];
+          hashes[state] = (hash ^ signature[symbolCount]) * 1099511628211ull;
+          buckets[thread][hashes[state] % threads].push_back(static_cast<std::uint32_t>(state));
+        }
+      });
+
+      // Each thread owns the signatures whose hash falls in its range, and finds the first state having each of them
+      runOnThreads(threads, [&](unsigned thread) {
+        std::unordered_set<std::uint32_t, decltype(signatureHash), decltype(sameSignature)> firsts(0, signatureHash, sameSignature);
+        // The chunks are visited in order, so the states are seen in increasing order
+        for (unsigned producer = 0; producer < threads; ++producer) {
+          for (const std::uint32_t state : buckets[producer][thread]) {
+            representatives[state] = *firsts.insert(state).first;
+          }
+        }
+      });
+
+      // Number the classes by order of first occurrence, as in the sequential version
+      std::uint32_t nextClassID = 0;
+      for (std::uint32_t state = 0; state < stateCount; ++state) {
+        newClasses[state] = representatives[state] == state ? nextClassID++ : newClasses[representatives[state]];
+      }
+
+      // Check to see if new iteration is different from previous
+      changed = newClasses != classes;
+      classes.swap(newClasses);
+    }
+
+    Automaton minimal(CD.getMemoryResource());
+    for (char symbol : CD.symbols) {
+      minimal.addSymbol(symbol);
+    }
 
+    // The representative of a class is its first state
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      if (representatives[state] != state) {
+        continue;
+      }
+      const int id = static_cast<int>(classes[state]);
+      minimal.addState(id);
+      if (finals[state]) {
+        minimal.setStateFinal(id);
+      }
+    }
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      if (CD.states.at(ids[state]).isInitial) {
+        minimal.setStateInitial(static_cast<int>(classes[state]));
+      }
+      if (representatives[state] == state) {
+        std::size_t symbol = 0;
+        for (char letter : CD.symbols) {
+          minimal.addTransition(static_cast<int>(classes[state]), letter, static_cast<int>(classes[targets[state * symbolCount + symbol++]]));
+        }
+      }
+    }
+
+    return minimal;
+  }
+
+  Automaton Automaton::createMinimalBrzozowski(const Automaton& other) {
+    return createMinimalBrzozowski(Automaton(other));
+  }
+
+  Automaton Automaton::createMinimalBrzozowski(Automaton&& other) {
+    other.removeNonAccessibleStates();
+
+    // The subset constructions always rebuild, so that only accessible subsets are kept
+    other.mirrorInPlace();
+    Automaton minimal = createDeterministic(other);
+
+    minimal.mirrorInPlace();
+    minimal = createDeterministic(minimal);
+
+    minimal.complete();
+
+    return minimal;
+  }
+
+  bool Automaton::updateMinimal(const std::vector<Edit>& edits) {
+    for (const Edit& edit : edits) {
+      if (!hasState(edit.from)) {
+        return false;
+      }
+      if (edit.kind == Edit::Kind::AddTransition && (!hasState(edit.to) || !hasSymbol(edit.symbol))) {
+        return false;
+      }
+      if (edit.kind == Edit::Kind::RemoveTransition && !hasSymbol(edit.symbol)) {
+        return false;
+      }
+    }
+
+    // Index the states and the columns of a dense table, checking that the automaton is a complete DFA
+    const std::size_t symbolCount = symbols.size();
+    std::array<std::size_t, 256> columns = {};
+    const std::string columnSymbols(symbols.begin(), symbols.end());
+    for (std::size_t c = 0; c < symbolCount; ++c) {
+      columns[static_cast<unsigned char>(columnSymbols[c])] = c;
+    }
+    std::vector<int> ids;
+    std::unordered_map<int, std::size_t> indices;
+    bool completeDeterministic = !hasEpsilonTransition();
+    for (const auto& state : states) {
+      indices.emplace(state.first, ids.size());
+      ids.push_back(state.first);
+      if (state.second.transitions.size() != symbolCount) {
+        completeDeterministic = false;
+      }
+      for (const auto& symbol : state.second.transitions) {
+        if (symbol.second.size() != 1) {
+          completeDeterministic = false;
+        }
+      }
+    }
+
+    if (!completeDeterministic) {
+      for (const Edit& edit : edits) {
+        State& state = states.at(edit.from);
+        switch (edit.kind) {
+          case Edit::Kind::AddTransition:
+            state.transitions.erase(edit.symbol);
+            addTransition(edit.from, edit.symbol, edit.to);
+            break;
+          case Edit::Kind::RemoveTransition:
+            state.transitions.erase(edit.symbol);
+            break;
+          case Edit::Kind::SetFinal:
+            state.isFinal = true;
+            break;
+          case Edit::Kind::SetNonFinal:
+            state.isFinal = false;
+            break;
+        }
+      }
+      *this = createMinimalMoore(std::move(*this));
+      return true;
+    }
+
+    std::vector<std::size_t> targets(ids.size() * symbolCount);
+    std::vector<std::uint8_t> finals(ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      const State& state = states.at(ids[i]);
+      finals[i] = state.isFinal;
+      for (const auto& symbol : state.transitions) {
+        targets[i * symbolCount + columns[static_cast<unsigned char>(symbol.first)]] = indices.at(*symbol.second.begin());
+      }
+    }
+
+    // Apply the edits to both the automaton and the table, the removed transitions
+    // lead to a sink state found afterwards, whose index is noSink for now
+    const std::size_t noSink = ids.size();
+    std::vector<std::size_t> edited;
+    std::vector<std::size_t> removed;
+    for (const Edit& edit : edits) {
+      State& state = states.at(edit.from);
+      const std::size_t from = indices.at(edit.from);
+      const std::size_t cell = from * symbolCount + columns[static_cast<unsigned char>(edit.symbol)];
+      switch (edit.kind) {
+        case Edit::Kind::AddTransition:
+          state.transitions.erase(edit.symbol);
+          addTransition(edit.from, edit.symbol, edit.to);
+          targets[cell] = indices.at(edit.to);
+          break;
+        case Edit::Kind::RemoveTransition:
+          state.transitions.erase(edit.symbol);
+          targets[cell] = noSink;
+          removed.push_back(cell);
+          break;
+        case Edit::Kind::SetFinal:
+          state.isFinal = true;
+          finals[from] = 1;
+          break;
+        case Edit::Kind::SetNonFinal:
+          state.isFinal = false;
+          finals[from] = 0;
+          break;
+      }
+      edited.push_back(from);
+    }
+
+    std::size_t sink = noSink;
+    if (std::any_of(removed.begin(), removed.end(), [&targets, noSink](std::size_t cell) { return targets[cell] == noSink; })) {
+      for (std::size_t i = 0; i < ids.size() && sink == noSink; ++i) {
+        bool loops = !finals[i];
+        for (std::size_t c = 0; c < symbolCount && loops; ++c) {
+          loops = targets[i * symbolCount + c] == i;
+        }
+        if (loops) {
+          sink = i;
+        }
+      }
+      if (sink == noSink) {
+        const int id = ids.back() + 1;
+        addState(id);
+        for (const char symbol : symbols) {
+          addTransition(id, symbol, id);
+        }
+        indices.emplace(id, ids.size());
+        ids.push_back(id);
+        finals.push_back(0);
+        targets.resize(targets.size() + symbolCount, sink);
+        edited.push_back(sink);
+      }
+      for (const std::size_t cell : removed) {
+        if (targets[cell] == noSink) {
+          targets[cell] = sink;
+          addTransition(ids[cell / symbolCount], columnSymbols[cell % symbolCount], ids[sink]);
+        }
+      }
+    }
+
+    // Index the predecessors, then collect the states reaching an edited one (B), the others keep their language (U)
+    const std::size_t stateCount = ids.size();
+    std::vector<std::size_t> predecessorStarts(stateCount + 1, 0);
+    for (const std::size_t target : targets) {
+      ++predecessorStarts[target + 1];
+    }
+    for (std::size_t i = 0; i < stateCount; ++i) {
+      predecessorStarts[i + 1] += predecessorStarts[i];
+    }
+    std::vector<std::size_t> predecessors(targets.size());
+    {
+      std::vector<std::size_t> fill(predecessorStarts.begin(), predecessorStarts.end() - 1);
+      for (std::size_t cell = 0; cell < targets.size(); ++cell) {
+        predecessors[fill[targets[cell]]++] = cell;
+      }
+    }
+
+    const std::size_t notAffected = stateCount;
+    std::vector<std::size_t> positions(stateCount, notAffected);
+    std::vector<std::size_t> affected;
+    for (const std::size_t state : edited) {
+      if (positions[state] == notAffected) {
+        positions[state] = affected.size();
+        affected.push_back(state);
+      }
+    }
+    for (std::size_t next = 0; next < affected.size(); ++next) {
+      const std::size_t state = affected[next];
+      for (std::size_t p = predecessorStarts[state]; p < predecessorStarts[state + 1]; ++p) {
+        const std::size_t predecessor = predecessors[p] / symbolCount;
+        if (positions[predecessor] == notAffected) {
+          positions[predecessor] = affected.size();
+          affected.push_back(predecessor);
+        }
+      }
+    }
+
+    // Candidate unchanged equivalents of each affected state: the predecessors of an
+    // unchanged target with the same symbol, or all the unchanged states with the same finality
+    std::vector<std::vector<std::size_t>> candidates(affected.size());
+    for (std::size_t b = 0; b < affected.size(); ++b) {
+      const std::size_t state = affected[b];
+      std::size_t anchor = symbolCount;
+      for (std::size_t c = 0; c < symbolCount && anchor == symbolCount; ++c) {
+        if (positions[targets[state * symbolCount + c]] == notAffected) {
+          anchor = c;
+        }
+      }
+      if (anchor != symbolCount) {
+        const std::size_t target = targets[state * symbolCount + anchor];
+        for (std::size_t p = predecessorStarts[target]; p < predecessorStarts[target + 1]; ++p) {
+          const std::size_t predecessor = predecessors[p] / symbolCount;
+          if (predecessors[p] % symbolCount == anchor && positions[predecessor] == notAffected && finals[predecessor] == finals[state]) {
+            candidates[b].push_back(predecessor);
+          }
+        }
+      } else {
+        for (std::size_t u = 0; u < stateCount; ++u) {
+          if (positions[u] == notAffected && finals[u] == finals[state]) {
+            candidates[b].push_back(u);
+          }
+        }
+      }
+      std::sort(candidates[b].begin(), candidates[b].end());
+    }
+
+    // Greatest fixpoint: an affected state stays equivalent to a candidate if their
+    // transitions lead to the same unchanged state or to a candidate pair
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (std::size_t b = 0; b < affected.size(); ++b) {
+        const std::size_t state = affected[b];
+        auto kept = std::remove_if(candidates[b].begin(), candidates[b].end(), [&](std::size_t u) {
+          for (std::size_t c = 0; c < symbolCount; ++c) {
+            const std::size_t target = targets[state * symbolCount + c];
+            const std::size_t other = targets[u * symbolCount + c];
+            if (positions[target] == notAffected) {
+              if (target != other) {
+                return true;
+              }
+            } else if (!std::binary_search(candidates[positions[target]].begin(), candidates[positions[target]].end(), other)) {
+              return true;
+            }
+          }
+          return false;
+        });
+        if (kept != candidates[b].end()) {
+          candidates[b].erase(kept, candidates[b].end());
+          changed = true;
+        }
+      }
+    }
+
+    // The unchanged states are pairwise distinct, so they keep their own class, numbered
+    // by their index; the affected states with no equivalent are refined among themselves
+    std::vector<std::size_t> classes(affected.size());
+    for (std::size_t b = 0; b < affected.size(); ++b) {
+      classes[b] = candidates[b].empty() ? stateCount + finals[affected[b]] : candidates[b].front();
+    }
+    auto classOf = [&](std::size_t state) {
+      return positions[state] == notAffected ? state : classes[positions[state]];
+    };
+    std::size_t classCount = 0;
+    changed = true;
+    while (changed) {
+      std::map<std::vector<std::size_t>, std::size_t> signatures;
+      std::vector<std::size_t> refined(classes);
+      for (std::size_t b = 0; b < affected.size(); ++b) {
+        if (!candidates[b].empty()) {
+          continue;
+        }
+        const std::size_t state = affected[b];
+        std::vector<std::size_t> signature(1, classes[b]);
+        for (std::size_t c = 0; c < symbolCount; ++c) {
+          signature.push_back(classOf(targets[state * symbolCount + c]));
+        }
+        refined[b] = signatures.emplace(std::move(signature), stateCount + signatures.size()).first->second;
+      }
+      changed = signatures.size() != classCount;
+      classCount = signatures.size();
+      classes = std::move(refined);
+    }
+
+    // Each class is represented by an unchanged state or by its first affected state
+    std::unordered_map<std::size_t, std::size_t> representatives;
+    for (std::size_t b = 0; b < affected.size(); ++b) {
+      if (classes[b] < stateCount) {
+        representatives.emplace(affected[b], classes[b]);
+      } else {
+        representatives.emplace(affected[b], representatives.emplace(classes[b], affected[b]).first->second);
+      }
+    }
+
+    // Only the affected states have transitions towards affected states
+    for (const std::size_t state : affected) {
+      const std::size_t representative = representatives.at(state);
+      if (representative != state) {
+        if (states.at(ids[state]).isInitial) {
+          states.at(ids[representative]).isInitial = true;
+        }
+        states.erase(ids[state]);
+        continue;
+      }
+      for (auto& symbol : states.at(ids[state]).transitions) {
+        const std::size_t target = targets[state * symbolCount + columns[static_cast<unsigned char>(symbol.first)]];
+        if (positions[target] != notAffected && representatives.at(target) != target) {
+          symbol.second.clear();
+          symbol.second.insert(ids[representatives.at(target)]);
+        }
+      }
+    }
+
+    removeNonAccessibleStates();
+    return true;
+  }
+
+
+
+  std::size_t Automaton::WordListBuilder::NodeHash::operator()(std::uint32_t node) const {
+    const Node& content = (*nodes)[node];
+    std::size_t hash = content.isFinal ? 1 : 0;
+    for (const auto& edge : content.edges) {
+      hash = hash * 31 + static_cast<unsigned char>(edge.first);
+      hash = hash * 1000003 + edge.second;
+    }
+    return hash;
+  }
+
+  bool Automaton::WordListBuilder::NodeEqual::operator()(std::uint32_t lhs, std::uint32_t rhs) const {
+    return (*nodes)[lhs].isFinal == (*nodes)[rhs].isFinal && (*nodes)[lhs].edges == (*nodes)[rhs].edges;
+  }
+
+  Automaton::WordListBuilder::WordListBuilder()
+  : nodes(1, Node{ false, {} }), freeNodes(), registry(0, NodeHash{ &nodes }, NodeEqual{ &nodes }), branch(1, 0), previous() {
+  }
+
+  void Automaton::WordListBuilder::minimize(std::size_t length) {
+    while (branch.size() > length + 1) {
+      const std::uint32_t child = branch.back();
+      branch.pop_back();
+      const auto equivalent = registry.find(child);
+      if (equivalent != registry.end()) {
+        nodes[branch.back()].edges.back().second = *equivalent;
+        nodes[child].edges.clear();
+        freeNodes.push_back(child);
+      } else {
+        registry.insert(child);
+      }
+    }
+  }
+
+  bool Automaton::WordListBuilder::add(std::string_view word) {
+    if (word < previous) {
+      return false;
+    }
+    for (const char c : word) {
+      if (!isgraph(static_cast<unsigned char>(c))) {
+        return false;
+      }
+    }
+
+    std::size_t prefix = 0;
+    while (prefix < word.size() && prefix < previous.size() && word[prefix] == previous[prefix]) {
+      ++prefix;
+    }
+    minimize(prefix);
+
+    for (std::size_t i = prefix; i < word.size(); ++i) {
+      std::uint32_t node;
+      if (freeNodes.empty()) {
+        node = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(Node{ false, {} });
+      } else {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[node].isFinal = false;
+      }
+      nodes[branch.back()].edges.emplace_back(word[i], node);
+      branch.push_back(node);
+    }
+    nodes[branch.back()].isFinal = true;
+    previous.assign(word.begin(), word.end());
+    return true;
+  }
+
+  Automaton Automaton::WordListBuilder::build() {
+    minimize(0);
+
+    // Number the states in breadth-first order from the root
+    Automaton automaton;
+    std::unordered_map<std::uint32_t, int> states = { { 0, 0 } };
+    std::vector<std::uint32_t> queue = { 0 };
+    automaton.addState(0);
+    automaton.setStateInitial(0);
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+      const Node& node = nodes[queue[next]];
+      const int state = states.at(queue[next]);
+      if (node.isFinal) {
+        automaton.setStateFinal(state);
+      }
+      for (const auto& edge : node.edges) {
+        const auto inserted = states.emplace(edge.second, static_cast<int>(states.size()));
+        if (inserted.second) {
+          automaton.addState(inserted.first->second);
+          queue.push_back(edge.second);
+        }
+        automaton.addSymbol(edge.first);
+        automaton.addTransition(state, edge.first, inserted.first->second);
+      }
+    }
+
+    registry.clear();
+    nodes.assign(1, Node{ false, {} });
+    freeNodes.clear();
+    branch.assign(1, 0);
+    previous.clear();
+    return automaton;
+  }
+
+  std::optional<Automaton> Automaton::createFromSortedWords(const std::vector<std::string>& words) {
+    return createFromSortedWords(words.begin(), words.end());
+  }
+
+  namespace {
+
+    bool hasSsse3() {
+#if FA_SIMD_X86
+      static const bool supported = __builtin_cpu_supports("ssse3");
+      return supported;
+#else
+      return false;
+#endif
+    }
+
+#if FA_SIMD_X86
+    /**
+     * Scan a word with byte shuffles, every byte of the register holds the current state
+     */
+    __attribute__((target("ssse3")))
+    std::uint32_t shuffleScan(const std::array<std::uint8_t, 16>* shuffles, std::uint32_t state, const char* word, std::size_t size) {
+      __m128i current = _mm_set1_epi8(static_cast<char>(state));
+      for (std::size_t i = 0; i < size; ++i) {
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffles[static_cast<unsigned char>(word[i])].data()));
+        current = _mm_shuffle_epi8(mask, current);
+      }
+      return static_cast<std::uint32_t>(_mm_cvtsi128_si32(current) & 0xff);
+    }
+
+    /**
+     * Find the first byte of a set with the truffle algorithm, 16 bytes at a time
+     *
+     * Each byte b selects the entry b & 15 of the mask of its half, and the
+     * set contains b if bit (b >> 4) & 7 of that entry is set.
+     * Returns the position of the last incomplete block if no byte is found.
+     */
+    __attribute__((target("ssse3")))
+    const char* truffleScan(const std::uint8_t* lowMasks, const std::uint8_t* highMasks, const char* begin, const char* end) {
+      const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lowMasks));
+      const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(highMasks));
+      const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+      const __m128i nibble = _mm_set1_epi8(0x0f);
+      const __m128i flip = _mm_set1_epi8(-128);
+      const __m128i zero = _mm_setzero_si128();
+
+      while (end - begin >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        // pshufb gives 0 for the indices having their high bit set, so each half only sees its bytes
+        const __m128i entries = _mm_or_si128(_mm_shuffle_epi8(low, block), _mm_shuffle_epi8(high, _mm_xor_si128(block, flip)));
+        const __m128i selector = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(block, 4), nibble));
+        const int misses = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(entries, selector), zero));
+        if (misses != 0xffff) {
+          return begin + __builtin_ctz(static_cast<unsigned>(~misses & 0xffff));
+        }
+        begin += 16;
+      }
+      return begin;
+    }
+
+    /**
+     * Scan four words in lockstep with byte shuffles, up to the length of the shortest one
+     */
+    __attribute__((target("ssse3")))
+    void shuffleScan4(const std::array<std::uint8_t, 16>* shuffles, std::uint32_t* states, const std::string_view* words, std::size_t size) {
+      __m128i current0 = _mm_set1_epi8(static_cast<char>(states[0]));
+      __m128i current1 = _mm_set1_epi8(static_cast<char>(states[1]));
+      __m128i current2 = _mm_set1_epi8(static_cast<char>(states[2]));
+      __m128i current3 = _mm_set1_epi8(static_cast<char>(states[3]));
+      for (std::size_t i = 0; i < size; ++i) {
+        const __m128i mask0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffles[static_cast<unsigned char>(words[0][i])].data()));
+        const __m128i mask1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffles[static_cast<unsigned char>(words[1][i])].data()));
+        const __m128i mask2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffles[static_cast<unsigned char>(words[2][i])].data()));
+        const __m128i mask3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffles[static_cast<unsigned char>(words[3][i])].data()));
+        current0 = _mm_shuffle_epi8(mask0, current0);
+        current1 = _mm_shuffle_epi8(mask1, current1);
+        current2 = _mm_shuffle_epi8(mask2, current2);
+        current3 = _mm_shuffle_epi8(mask3, current3);
+      }
+      states[0] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(current0) & 0xff);
+      states[1] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(current1) & 0xff);
+      states[2] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(current2) & 0xff);
+      states[3] = static_cast<std::uint32_t>(_mm_cvtsi128_si32(current3) & 0xff);
+    }
+#endif
+
+  }
+
+  CompiledAutomaton::CompiledAutomaton(const Automaton& automaton)
+  : columns(), columnCount(1), initial(0), finals(), table(), shuffles(), requiredPrefix(), firstBytes(), accelerations(), exits() {
+    Automaton determinized(automaton.getMemoryResource());
+    const Automaton* source = &automaton;
+    if (!automaton.isDeterministic()) {
+      determinized = Automaton::createDeterministic(automaton);
+      source = &determinized;
+    }
+
+    // Column 0 is shared by all the bytes that are not symbols
+    for (const char symbol : source->symbols) {
+      columns[static_cast<unsigned char>(symbol)] = static_cast<std::uint8_t>(columnCount++);
+    }
+
+    // Find the co-accessible states with a backward search from the final states
+    std::unordered_map<int, std::vector<int>> predecessors;
+    std::unordered_set<int> coAccessible;
+    std::queue<int> queue;
+    for (const auto& state : source->states) {
+      for (const auto& symbol : state.second.transitions) {
+        for (int arrival : symbol.second) {
+          predecessors[arrival].push_back(state.first);
+        }
+      }
+      if (state.second.isFinal) {
+        coAccessible.insert(state.first);
+        queue.push(state.first);
+      }
+    }
+    while (!queue.empty()) {
+      int current = queue.front();
+      queue.pop();
+      for (int predecessor : predecessors[current]) {
+        if (coAccessible.insert(predecessor).second) {
+          queue.push(predecessor);
+        }
+      }
+    }
+
+    // Number the useful states in breadth-first order from the initial state, 0 is the dead state
+    std::unordered_map<int, std::uint32_t> numbers;
+    std::vector<int> order;
+    for (const auto& state : source->states) {
+      if (state.second.isInitial && coAccessible.count(state.first)) {
+        numbers[state.first] = 1;
+        order.push_back(state.first);
+      }
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      for (const auto& symbol : source->states.at(order[i]).transitions) {
+        int arrival = *symbol.second.begin();
+        if (coAccessible.count(arrival) && numbers.find(arrival) == numbers.end()) {
+          numbers[arrival] = static_cast<std::uint32_t>(order.size() + 1);
+          order.push_back(arrival);
+        }
+      }
+    }
+
+    const std::size_t stateCount = order.size() + 1;
+    initial = order.empty() ? 0 : 1;
+    finals.assign(stateCount, 0);
+    std::vector<std::uint32_t> transitions(stateCount * columnCount, 0);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      const auto& state = source->states.at(order[i]);
+      finals[i + 1] = state.isFinal ? 1 : 0;
+      for (const auto& symbol : state.transitions) {
+        auto arrival = numbers.find(*symbol.second.begin());
+        if (arrival != numbers.end() && symbol.first != fa::Epsilon) {
+          transitions[(i + 1) * columnCount + columns[static_cast<unsigned char>(symbol.first)]] = arrival->second;
+        }
+      }
+    }
+
+    // Select the narrowest width able to store every state index
+    if (stateCount <= std::numeric_limits<std::uint8_t>::max() + std::size_t(1)) {
+      table = std::vector<std::uint8_t>(transitions.begin(), transitions.end());
+    } else if (stateCount <= std::numeric_limits<std::uint16_t>::max() + std::size_t(1)) {
+      table = std::vector<std::uint16_t>(transitions.begin(), transitions.end());
+    } else {
+      table = std::move(transitions);
+    }
+
+    // With at most 16 states, the transitions of each byte fit in a shuffle mask
+    if (stateCount <= 16) {
+      shuffles.resize(256);
+      for (std::size_t byte = 0; byte < 256; ++byte) {
+        shuffles[byte].fill(0);
+        for (std::uint32_t state = 0; state < stateCount; ++state) {
+          shuffles[byte][state] = static_cast<std::uint8_t>(next(state, static_cast<char>(byte)));
+        }
+      }
+    }
+
+    // A state looping on nearly all the symbols is left by searching the other bytes. The bytes
+    // that are not symbols always leave it, so only the symbols leaving it are limited: with
+    // more of them, the runs are too short for a search to beat stepping through the table.
+    constexpr std::size_t MaxExitSymbols = 3;
+    accelerations.assign(stateCount, 0);
+    for (std::uint32_t state = 1; state < stateCount; ++state) {
+      std::array<std::uint8_t, 256> leaving;
+      leaving.fill(1);
+      std::size_t loops = 0;
+      for (const char symbol : source->symbols) {
+        if (next(state, symbol) == state) {
+          leaving[static_cast<unsigned char>(symbol)] = 0;
+          ++loops;
+        }
+      }
+      const std::size_t exitSymbols = source->symbols.size() - loops;
+      if (loops > 0 && exitSymbols <= MaxExitSymbols && loops >= 4 * exitSymbols) {
+        exits.emplace_back(leaving);
+        accelerations[state] = static_cast<std::uint32_t>(exits.size());
+      }
+    }
+
+    // The bytes that leave the initial state without dying can start a word
+    std::array<std::uint8_t, 256> starts = {};
+    for (const char symbol : source->symbols) {
+      if (next(initial, symbol) != 0) {
+        starts[static_cast<unsigned char>(symbol)] = 1;
+      }
+    }
+    firstBytes = ByteSet(starts);
+
+    // Follow the states having a single way out to find the prefix of every word
+    std::uint32_t state = initial;
+    while (state != 0 && finals[state] == 0 && requiredPrefix.size() < stateCount) {
+      std::uint32_t target = 0;
+      char only = fa::Epsilon;
+      std::size_t ways = 0;
+      for (const char symbol : source->symbols) {
+        if (next(state, symbol) != 0) {
+          target = next(state, symbol);
+          only = symbol;
+          ++ways;
+        }
+      }
+      if (ways != 1) {
+        break;
+      }
+      requiredPrefix.push_back(only);
+      state = target;
+    }
+  }
+
+  std::size_t CompiledAutomaton::countStates() const {
+    return finals.size();
+  }
+
+  std::size_t CompiledAutomaton::countColumns() const {
+    return columnCount;
+  }
+
+  std::size_t CompiledAutomaton::getStateWidth() const {
+    return std::visit([](const auto& transitions) {
+      return sizeof(typename std::decay_t<decltype(transitions)>::value_type);
+    }, table);
+  }
+
+  std::size_t CompiledAutomaton::getTableSize() const {
+    return countStates() * countColumns() * getStateWidth();
+  }
+
+  std::uint32_t CompiledAutomaton::getInitialState() const {
+    return initial;
+  }
+
+  bool CompiledAutomaton::isStateAccelerated(std::uint32_t state) const {
+    return state < accelerations.size() && accelerations[state] != 0;
+  }
+
+  bool CompiledAutomaton::isStateFinal(std::uint32_t state) const {
+    return state < finals.size() && finals[state] != 0;
+  }
+
+  std::uint32_t CompiledAutomaton::next(std::uint32_t state, char symbol) const {
+    const std::size_t column = columns[static_cast<unsigned char>(symbol)];
+    return std::visit([this, state, column](const auto& transitions) {
+      return static_cast<std::uint32_t>(transitions[state * columnCount + column]);
+    }, table);
+  }
+
+  template<typename Index>
+  bool CompiledAutomaton::matchTable(const std::vector<Index>& transitions, std::string_view word) const {
+    const Index* data = transitions.data();
+    std::uint32_t state = initial;
+    if (exits.empty()) {
+      for (const char c : word) {
+        state = data[state * columnCount + columns[static_cast<unsigned char>(c)]];
+        if (state == 0) {
+          return false;
+        }
+      }
+      return finals[state] != 0;
+    }
+
+    const char* position = word.data();
+    const char* end = position + word.size();
+    while (position != end) {
+      if (accelerations[state] != 0) {
+        position = exits[accelerations[state] - 1].find(position, end);
+        if (position == end) {
+          break;
+        }
+      }
+      state = data[state * columnCount + columns[static_cast<unsigned char>(*position++)]];
+      if (state == 0) {
+        return false;
+      }
+    }
+    return finals[state] != 0;
+  }
+
+  bool CompiledAutomaton::match(std::string_view word) const {
+#if FA_SIMD_X86
+    // The shuffles step through any small DFA faster, the accelerated states help the larger tables
+    if (isShuffleAccelerated()) {
+      return finals[shuffleScan(shuffles.data(), initial, word.data(), word.size())] != 0;
+    }
+#endif
+    return std::visit([this, word](const auto& transitions) {
+      return matchTable(transitions, word);
+    }, table);
+  }
+
+  namespace {
+
+    /**
+     * Below this size per thread, a word is scanned by a single thread
+     */
+    constexpr std::size_t ParallelChunkSize = 1 << 14;
+
+  }
+
+  template<typename Index>
+  bool CompiledAutomaton::matchTableParallel(const std::vector<Index>& transitions, std::string_view word, unsigned threads) const {
+    const Index* data = transitions.data();
+    const std::size_t stateCount = countStates();
+    const std::size_t chunkSize = (word.size() + threads - 1) / threads;
+    constexpr std::uint32_t None = std::numeric_limits<std::uint32_t>::max();
+
+    // endStates[chunk][state] is the state reached at the end of the chunk from the state
+    std::vector<std::vector<std::uint32_t>> endStates(threads);
+    std::uint32_t firstEnd = 0;
+
+    runOnThreads(threads, [&](unsigned chunk) {
+      const std::size_t begin = std::min(word.size(), chunk * chunkSize);
+      const std::size_t end = std::min(word.size(), begin + chunkSize);
+
+      if (chunk == 0) {
+        std::uint32_t state = initial;
+        for (std::size_t i = begin; i < end && state != 0; ++i) {
+          state = data[state * columnCount + columns[static_cast<unsigned char>(word[i])]];
+        }
+        firstEnd = state;
+        return;
+      }
+
+      // One lane per state at first, the lanes that reach the same state are merged from time to time
+      std::vector<std::uint32_t> lanes(stateCount);
+      for (std::uint32_t state = 0; state < stateCount; ++state) {
+        lanes[state] = state;
+      }
+      std::vector<std::vector<std::uint32_t>> merges;
+      std::vector<std::uint32_t> laneOfState(stateCount, None);
+      std::size_t interval = 16;
+      std::size_t nextMerge = begin + interval;
+
+      for (std::size_t i = begin; i < end; ++i) {
+        const std::size_t column = columns[static_cast<unsigned char>(word[i])];
+        for (std::uint32_t& lane : lanes) {
+          lane = data[lane * columnCount + column];
+        }
+
+        if (i + 1 == nextMerge && lanes.size() > 1) {
+          std::vector<std::uint32_t> merge(lanes.size());
+          std::vector<std::uint32_t> merged;
+          for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+            if (laneOfState[lanes[lane]] == None) {
+              laneOfState[lanes[lane]] = static_cast<std::uint32_t>(merged.size());
+              merged.push_back(lanes[lane]);
+            }
+            merge[lane] = laneOfState[lanes[lane]];
+          }
+          for (std::uint32_t state : merged) {
+            laneOfState[state] = None;
+          }
+          if (merged.size() < lanes.size()) {
+            lanes.swap(merged);
+            merges.push_back(std::move(merge));
+          }
+          interval = std::min<std::size_t>(interval * 2, ParallelChunkSize);
+          nextMerge = i + 1 + interval;
+        }
+      }
+
+      // Go back through the merges to find the lane, hence the end state, of every start state
+      std::vector<std::uint32_t> ends = std::move(lanes);
+      for (auto merge = merges.rbegin(); merge != merges.rend(); ++merge) {
+        std::vector<std::uint32_t> previous(merge->size());
+        for (std::size_t lane = 0; lane < merge->size(); ++lane) {
+          previous[lane] = ends[(*merge)[lane]];
+        }
+        ends.swap(previous);
+      }
+      endStates[chunk] = std::move(ends);
+    });
+
+    std::uint32_t state = firstEnd;
+    for (unsigned chunk = 1; chunk < threads && state != 0; ++chunk) {
+      state = endStates[chunk][state];
+    }
+    return finals[state] != 0;
+  }
+
+  template<typename Index>
+  void CompiledAutomaton::matchTableInterleaved(const std::vector<Index>& transitions, const std::vector<std::string_view>& words, unsigned lanes, std::vector<bool>& result) const {
+    struct Lane {
+      const char* position;
+      const char* end;
+      std::uint32_t state;
+      std::size_t word;
+    };
+
+    const Index* data = transitions.data();
+    std::array<Lane, 16> lane;
+    unsigned active = 0;
+    std::size_t nextWord = 0;
+
+    for (;;) {
+      // Give a new word to every free lane
+      while (active < lanes && nextWord < words.size()) {
+        const std::string_view word = words[nextWord];
+        if (word.empty() || initial == 0) {
+          result[nextWord++] = finals[initial] != 0;
+          continue;
+        }
+        lane[active++] = Lane{ word.data(), word.data() + word.size(), initial, nextWord++ };
+      }
+      if (active == 0) {
+        return;
+      }
+
+      // All the lanes can go as far as the shortest remaining word without any check
+      std::size_t steps = static_cast<std::size_t>(lane[0].end - lane[0].position);
+      for (unsigned k = 1; k < active; ++k) {
+        steps = std::min(steps, static_cast<std::size_t>(lane[k].end - lane[k].position));
+      }
+      for (std::size_t step = 0; step < steps; ++step) {
+        for (unsigned k = 0; k < active; ++k) {
+          lane[k].state = data[lane[k].state * columnCount + columns[static_cast<unsigned char>(*lane[k].position++)]];
+        }
+      }
+
+      // Release the lanes whose word is over or which are in the dead state
+      for (unsigned k = 0; k < active;) {
+        if (lane[k].position == lane[k].end || lane[k].state == 0) {
+          result[lane[k].word] = finals[lane[k].state] != 0;
+          lane[k] = lane[--active];
+        } else {
+          ++k;
+        }
+      }
+    }
+  }
+
+  std::vector<bool> CompiledAutomaton::matchAll(const std::vector<std::string_view>& words, unsigned lanes) const {
+    std::vector<bool> result(words.size());
+#if FA_SIMD_X86
+    if (isShuffleAccelerated()) {
+      std::size_t first = 0;
+      // Groups of four words go together up to the shortest one, then each one finishes alone
+      for (; first + 4 <= words.size(); first += 4) {
+        std::size_t common = words[first].size();
+        for (std::size_t i = 1; i < 4; ++i) {
+          common = std::min(common, words[first + i].size());
+        }
+        std::uint32_t states[4] = { initial, initial, initial, initial };
+        shuffleScan4(shuffles.data(), states, &words[first], common);
+        for (std::size_t i = 0; i < 4; ++i) {
+          const std::string_view rest = words[first + i].substr(common);
+          result[first + i] = finals[shuffleScan(shuffles.data(), states[i], rest.data(), rest.size())] != 0;
+        }
+      }
+      for (; first < words.size(); ++first) {
+        result[first] = match(words[first]);
+      }
+      return result;
+    }
+#endif
+    lanes = std::max(1u, std::min(lanes, 16u));
+    std::visit([this, &words, lanes, &result](const auto& transitions) {
+      matchTableInterleaved(transitions, words, lanes, result);
+    }, table);
+    return result;
+  }
+
+  bool CompiledAutomaton::isShuffleAccelerated() const {
+    return !shuffles.empty() && hasSsse3();
+  }
+
+  const std::string& CompiledAutomaton::getRequiredPrefix() const {
+    return requiredPrefix;
+  }
+
+  std::string CompiledAutomaton::getFirstBytes() const {
+    std::string bytes;
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+      if (firstBytes.members[byte]) {
+        bytes.push_back(static_cast<char>(byte));
+      }
+    }
+    return bytes;
+  }
+
+  CompiledAutomaton::ByteSet::ByteSet()
+  : members(), lowMasks(), highMasks(), count(0), single(0) {
+  }
+
+  CompiledAutomaton::ByteSet::ByteSet(const std::array<std::uint8_t, 256>& bytes)
+  : members(bytes), lowMasks(), highMasks(), count(0), single(0) {
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+      if (members[byte]) {
+        std::array<std::uint8_t, 16>& masks = byte < 128 ? lowMasks : highMasks;
+        masks[byte & 15] = static_cast<std::uint8_t>(masks[byte & 15] | (1u << ((byte >> 4) & 7)));
+        single = static_cast<char>(byte);
+        ++count;
+      }
+    }
+  }
+
+  const char* CompiledAutomaton::ByteSet::find(const char* begin, const char* end) const {
+    if (count == 0) {
+      return end;
+    }
+    if (count == 1) {
+      const void* found = std::memchr(begin, single, static_cast<std::size_t>(end - begin));
+      return found == nullptr ? end : static_cast<const char*>(found);
+    }
+#if FA_SIMD_X86
+    if (hasSsse3()) {
+      begin = truffleScan(lowMasks.data(), highMasks.data(), begin, end);
+    }
+#endif
+    while (begin != end && !members[static_cast<unsigned char>(*begin)]) {
+      ++begin;
+    }
+    return begin;
+  }
+
+  std::size_t CompiledAutomaton::find(std::string_view text) const {
+    if (initial == 0) {
+      return std::string_view::npos;
+    }
+    if (finals[initial]) {
+      return 0;
+    }
+
+    // The runs started at each position are followed together. Runs in the
+    // same state at the same position have the same future, so only the
+    // earliest start is kept for each state and each byte is read at most
+    // once per state.
+    constexpr std::size_t None = std::string_view::npos;
+    const std::size_t stateCount = finals.size();
+    std::vector<std::size_t> starts(stateCount, None);
+    std::vector<std::size_t> nextStarts(stateCount, None);
+    std::vector<std::uint32_t> active;
+    std::vector<std::uint32_t> nextActive;
+    std::size_t best = None;
+
+    std::size_t position = 0;
+    while (position < text.size()) {
+      if (active.empty()) {
+        if (best != None) {
+          return best;
+        }
+        // Jump to the next position where an accepted word can start
+        if (!requiredPrefix.empty()) {
+          position = text.find(requiredPrefix, position);
+        } else {
+          const char* found = firstBytes.find(text.data() + position, text.data() + text.size());
+          position = found == text.data() + text.size() ? None : static_cast<std::size_t>(found - text.data());
+        }
+        if (position == None) {
+          return None;
+        }
+      }
+
+      // Once a word is found, the runs starting later cannot give an earlier one
+      if (best == None && starts[initial] == None) {
+        starts[initial] = position;
+        active.push_back(initial);
+      }
+
+      // A single run left, with no new run to start, can skip its self-loops
+      if (active.size() == 1 && best != None && accelerations[active.front()] != 0) {
+        const char* exit = exits[accelerations[active.front()] - 1].find(text.data() + position, text.data() + text.size());
+        position = static_cast<std::size_t>(exit - text.data());
+        if (position == text.size()) {
+          break;
+        }
+      }
+
+      const char byte = text[position++];
+      nextActive.clear();
+      for (const std::uint32_t state : active) {
+        const std::size_t start = starts[state];
+        starts[state] = None;
+        const std::uint32_t arrival = next(state, byte);
+        if (arrival == 0 || start >= best) {
+          continue;
+        }
+        if (finals[arrival]) {
+          best = start;
+          continue;
+        }
+        if (nextStarts[arrival] == None) {
+          nextActive.push_back(arrival);
+          nextStarts[arrival] = start;
+        } else {
+          nextStarts[arrival] = std::min(nextStarts[arrival], start);
+        }
+      }
+      active.swap(nextActive);
+      starts.swap(nextStarts);
+    }
+    return best;
+  }
+
+  bool CompiledAutomaton::match(std::string_view word, unsigned threads) const {
+    threads = static_cast<unsigned>(std::min<std::size_t>(resolveThreadCount(threads), word.size() / ParallelChunkSize));
+    if (threads <= 1 || initial == 0) {
+      return match(word);
+    }
+    return std::visit([this, word, threads](const auto& transitions) {
+      return matchTableParallel(transitions, word, threads);
+    }, table);
+  }
+
+
+
+  CompressedAutomaton::CompressedAutomaton(const Automaton& automaton)
+  : CompressedAutomaton(CompiledAutomaton(automaton)) {
+  }
+
+  CompressedAutomaton::CompressedAutomaton(const CompiledAutomaton& compiled)
+  : columns(compiled.columns), initial(compiled.initial), finals(compiled.finals), defaults(), bases(), nexts(), checks() {
+    constexpr std::uint32_t Free = std::numeric_limits<std::uint32_t>::max();
+    const std::size_t stateCount = compiled.countStates();
+    const std::size_t columnCount = compiled.countColumns();
+
+    // Split every row into its most frequent target and the entries that differ from it
+    defaults.assign(stateCount, 0);
+    bases.assign(stateCount, 0);
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> rows(stateCount);
+    std::unordered_map<std::uint32_t, std::size_t> frequencies;
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      frequencies.clear();
+      std::uint32_t best = 0;
+      std::size_t bestCount = 0;
+      for (std::size_t column = 0; column < columnCount; ++column) {
+        std::uint32_t target = std::visit([state, column, columnCount](const auto& transitions) {
+          return static_cast<std::uint32_t>(transitions[state * columnCount + column]);
+        }, compiled.table);
+        std::size_t count = ++frequencies[target];
+        if (count > bestCount || (count == bestCount && target < best)) {
+          best = target;
+          bestCount = count;
+        }
+      }
+      defaults[state] = best;
+      for (std::size_t column = 0; column < columnCount; ++column) {
+        std::uint32_t target = std::visit([state, column, columnCount](const auto& transitions) {
+          return static_cast<std::uint32_t>(transitions[state * columnCount + column]);
+        }, compiled.table);
+        if (target != best) {
+          rows[state].emplace_back(static_cast<std::uint32_t>(column), target);
+        }
+      }
+    }
+
+    // Place the fullest rows first, each one at the first base where its entries fit
+    std::vector<std::uint32_t> order;
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      if (!rows[state].empty()) {
+        order.push_back(state);
+      }
+    }
+    std::stable_sort(order.begin(), order.end(), [&rows](std::uint32_t lhs, std::uint32_t rhs) {
+      return rows[lhs].size() > rows[rhs].size();
+    });
+
+    std::size_t firstFree = 0;
+    for (std::uint32_t state : order) {
+      const auto& row = rows[state];
+      std::size_t base = firstFree > row.front().first ? firstFree - row.front().first : 0;
+      for (;; ++base) {
+        if (checks.size() < base + columnCount) {
+          checks.resize(base + columnCount, Free);
+          nexts.resize(base + columnCount, 0);
+        }
+        bool fits = true;
+        for (const auto& entry : row) {
+          if (checks[base + entry.first] != Free) {
+            fits = false;
+            break;
+          }
+        }
+        if (fits) {
+          break;
+        }
+      }
+
+      bases[state] = static_cast<std::uint32_t>(base);
+      for (const auto& entry : row) {
+        checks[base + entry.first] = state;
+        nexts[base + entry.first] = entry.second;
+      }
+      while (firstFree < checks.size() && checks[firstFree] != Free) {
+        ++firstFree;
+      }
+    }
+
+    // Every base plus column must stay inside the arrays
+    checks.resize(std::max(checks.size(), columnCount), Free);
+    nexts.resize(checks.size(), 0);
+    checks.shrink_to_fit();
+    nexts.shrink_to_fit();
+  }
+
+  std::size_t CompressedAutomaton::countStates() const {
+    return finals.size();
+  }
+
+  std::size_t CompressedAutomaton::getTableSize() const {
+    return (defaults.size() + bases.size() + nexts.size() + checks.size()) * sizeof(std::uint32_t);
+  }
+
+  std::uint32_t CompressedAutomaton::getInitialState() const {
+    return initial;
+  }
+
+  bool CompressedAutomaton::isStateFinal(std::uint32_t state) const {
+    return state < finals.size() && finals[state] != 0;
+  }
+
+  std::uint32_t CompressedAutomaton::next(std::uint32_t state, char symbol) const {
+    const std::uint32_t index = bases[state] + columns[static_cast<unsigned char>(symbol)];
+    return checks[index] == state ? nexts[index] : defaults[state];
+  }
+
+  bool CompressedAutomaton::match(std::string_view word) const {
+    const std::uint32_t* base = bases.data();
+    const std::uint32_t* next = nexts.data();
+    const std::uint32_t* check = checks.data();
+    const std::uint32_t* fallback = defaults.data();
+    std::uint32_t state = initial;
+    for (const char c : word) {
+      // Both candidates are loaded so that the selection compiles to a conditional move
+      const std::uint32_t index = base[state] + columns[static_cast<unsigned char>(c)];
+      const std::uint32_t stored = next[index];
+      const std::uint32_t other = fallback[state];
+      state = check[index] == state ? stored : other;
+      if (state == 0) {
+        return false;
+      }
+    }
+    return finals[state] != 0;
+  }
+  Snapshot::Snapshot(const Automaton& source)
+  : automaton(std::pmr::new_delete_resource()), compiled(source) {
+    // Assigning keeps the resource of the destination
+    automaton = source;
+  }
+
+  std::shared_ptr<const Snapshot> Snapshot::create(const Automaton& automaton) {
+    return std::make_shared<const Snapshot>(automaton);
+  }
+
+  const Automaton& Snapshot::getAutomaton() const {
+    return automaton;
+  }
+
+  const CompiledAutomaton& Snapshot::getCompiled() const {
+    return compiled;
+  }
+
+  bool Snapshot::match(std::string_view word) const {
+    return compiled.match(word);
+  }
+
+  std::size_t Snapshot::find(std::string_view text) const {
+    return compiled.find(text);
+  }
+
+  SnapshotSlot::SnapshotSlot(std::shared_ptr<const Snapshot> snapshot)
+  : current(std::move(snapshot)) {
+  }
+
+  std::shared_ptr<const Snapshot> SnapshotSlot::load() const {
+    return std::atomic_load(&current);
+  }
+
+  void SnapshotSlot::store(std::shared_ptr<const Snapshot> snapshot) {
+    std::atomic_store(&current, std::move(snapshot));
+  }
+
+  namespace {
+
+    /**
+     * Print a byte as a C++ character literal
+     */
+    void printCharLiteral(std::ostream& os, char c) {
+      os << '\'';
+      if (c == '\'' || c == '\\') {
+        os << '\\';
+      }
+      os << c << '\'';
+    }
+
+  }
+
+  void Automaton::generateCpp(std::ostream& os, const CppGeneratorOptions& options) const {
+    const Automaton minimal = createMinimalMoore(*this);
+    const CompiledAutomaton compiled(minimal);
+    const std::uint32_t stateCount = static_cast<std::uint32_t>(compiled.countStates());
+
+    os << "#include <string_view>\n";
+    os << "\n";
+    os << "// Minimal automaton with " << stateCount - 1 << " states\n";
+    os << "bool " << options.functionName << "(std::string_view word) {\n";
+
+    if (options.style == CppGeneratorOptions::Style::Goto) {
+      if (compiled.getInitialState() == 0) {
+        os << "  static_cast<void>(word);\n";
+        os << "  return false;\n";
+        os << "}\n";
+        return;
+      }
+      os << "  const char* current = word.data();\n";
+      os << "  const char* end = current + word.size();\n";
+      os << "  goto state" << compiled.getInitialState() << ";\n";
+      for (std::uint32_t state = 1; state < stateCount; ++state) {
+        os << "state" << state << ":\n";
+        os << "  if (current == end) {\n";
+        os << "    return " << (compiled.isStateFinal(state) ? "true" : "false") << ";\n";
+        os << "  }\n";
+        os << "  switch (*current++) {\n";
+        // One group of cases for each target state
+        std::map<std::uint32_t, std::string> targets;
+        for (const char symbol : minimal.symbols) {
+          const std::uint32_t target = compiled.next(state, symbol);
+          if (target != 0) {
+            targets[target].push_back(symbol);
+          }
+        }
+        for (const auto& target : targets) {
+          os << "   ";
+          for (const char symbol : target.second) {
+            os << " case ";
+            printCharLiteral(os, symbol);
+            os << ":";
+          }
+          os << " goto state" << target.first << ";\n";
+        }
+        os << "    default: return false;\n";
+        os << "  }\n";
+      }
+      os << "}\n";
+      return;
+    }
+
+    // The columns are numbered as the sorted symbols, column 0 is for the other bytes
+    const char* index = stateCount <= 256 ? "unsigned char" : stateCount <= 65536 ? "unsigned short" : "unsigned int";
+    os << "  static constexpr unsigned char columns[256] = {";
+    std::array<std::size_t, 256> columns = {};
+    std::size_t column = 0;
+    for (const char symbol : minimal.symbols) {
+      columns[static_cast<unsigned char>(symbol)] = ++column;
+    }
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+      os << (byte % 32 == 0 ? "\n    " : " ") << columns[byte] << ",";
+    }
+    os << "\n  };\n";
+    os << "  static constexpr " << index << " transitions[" << stateCount << "][" << column + 1 << "] = {\n";
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      os << "    { 0,";
+      for (const char symbol : minimal.symbols) {
+        os << " " << compiled.next(state, symbol) << ",";
+      }
+      os << " },\n";
+    }
+    os << "  };\n";
+    os << "  static constexpr bool finals[" << stateCount << "] = {";
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      os << " " << (compiled.isStateFinal(state) ? "true" : "false") << ",";
+    }
+    os << " };\n";
+    os << "  unsigned state = " << compiled.getInitialState() << ";\n";
+    os << "  for (const char c : word) {\n";
+    os << "    state = transitions[state][columns[static_cast<unsigned char>(c)]];\n";
+    os << "    if (state == 0) {\n";
+    os << "      return false;\n";
+    os << "    }\n";
+    os << "  }\n";
+    os << "  return finals[state];\n";
+    os << "}\n";
+  }
+
+  namespace {
+
+    /**
+     * A natural number in base 10^9, for the exact counts
+     */
+    class BigNatural {
+    public:
+      explicit BigNatural(std::uint32_t value = 0)
+      : limbs() {
+        if (value != 0) {
+          limbs.push_back(value % Base);
+          if (value >= Base) {
+            limbs.push_back(value / Base);
+          }
+        }
+      }
+
+      bool isZero() const {
+        return limbs.empty();
+      }
+
+      void add(const BigNatural& other) {
+        if (limbs.size() < other.limbs.size()) {
+          limbs.resize(other.limbs.size(), 0);
+        }
+        std::uint32_t carry = 0;
+        for (std::size_t i = 0; i < limbs.size(); ++i) {
+          const std::uint32_t sum = limbs[i] + carry + (i < other.limbs.size() ? other.limbs[i] : 0);
+          carry = sum >= Base ? 1 : 0;
+          limbs[i] = sum - carry * Base;
+          if (carry == 0 && i >= other.limbs.size()) {
+            break;
+          }
+        }
+        if (carry != 0) {
+          limbs.push_back(carry);
+        }
+      }
+
+      std::string toString() const {
+        if (limbs.empty()) {
+          return "0";
+        }
+        std::string result = std::to_string(limbs.back());
+        for (std::size_t i = limbs.size() - 1; i > 0; --i) {
+          const std::string digits = std::to_string(limbs[i - 1]);
+          result.append(9 - digits.size(), '0');
+          result += digits;
+        }
+        return result;
+      }
+
+    private:
+      static constexpr std::uint32_t Base = 1000000000;
+      // Least significant limb first, no leading zero
+      std::vector<std::uint32_t> limbs;
+    };
+
+    /**
+     * The transitions of a compiled automaton as a list of edges, without the dead state
+     */
+    struct CountingGraph {
+      std::size_t stateCount;
+      std::uint32_t initial;
+      std::vector<std::uint8_t> finals;
+      std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+    };
+
+    CountingGraph makeCountingGraph(const CompiledAutomaton& compiled) {
+      CountingGraph graph = { compiled.countStates(), compiled.getInitialState(), {}, {} };
+      for (std::uint32_t state = 0; state < graph.stateCount; ++state) {
+        graph.finals.push_back(compiled.isStateFinal(state));
+      }
+      if (graph.initial == 0) {
+        return graph;
+      }
+      for (std::uint32_t state = 1; state < graph.stateCount; ++state) {
+        for (std::size_t byte = 0; byte < 256; ++byte) {
+          const std::uint32_t target = compiled.next(state, static_cast<char>(byte));
+          if (target != 0) {
+            graph.edges.emplace_back(state, target);
+          }
+        }
+      }
+      return graph;
+    }
+
+    std::string countExactly(const CountingGraph& graph, std::size_t length, bool upTo) {
+      BigNatural total;
+      if (graph.initial == 0) {
+        return total.toString();
+      }
+      std::vector<BigNatural> current(graph.stateCount);
+      current[graph.initial] = BigNatural(1);
+      for (std::size_t step = 0; ; ++step) {
+        if (upTo || step == length) {
+          for (std::size_t state = 1; state < graph.stateCount; ++state) {
+            if (graph.finals[state]) {
+              total.add(current[state]);
+            }
+          }
+        }
+        if (step == length) {
+          break;
+        }
+        std::vector<BigNatural> next(graph.stateCount);
+        for (const auto& edge : graph.edges) {
+          if (!current[edge.first].isZero()) {
+            next[edge.second].add(current[edge.first]);
+          }
+        }
+        current = std::move(next);
+      }
+      return total.toString();
+    }
+
+    // A modulus of 0 stands for 2^64, where the arithmetic wraps around
+    std::uint64_t addModulo(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t modulus) {
+      if (modulus == 0 || lhs < modulus - rhs) {
+        return lhs + rhs;
+      }
+      return lhs - (modulus - rhs);
+    }
+
+    std::uint64_t multiplyModulo(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t modulus) {
+      if (modulus == 0) {
+        return lhs * rhs;
+      }
+#if defined(__SIZEOF_INT128__)
+      __extension__ typedef unsigned __int128 Wide;
+      return static_cast<std::uint64_t>(static_cast<Wide>(lhs) * rhs % modulus);
+#else
+      std::uint64_t result = 0;
+      for (lhs %= modulus; rhs != 0; rhs >>= 1) {
+        if (rhs & 1) {
+          result = addModulo(result, lhs, modulus);
+        }
+        lhs = addModulo(lhs, lhs, modulus);
+      }
+      return result;
+#endif
+    }
+
+    std::uint64_t countModulo(const CountingGraph& graph, std::size_t length, std::uint64_t modulus, bool upTo) {
+      if (graph.initial == 0 || modulus == 1) {
+        return 0;
+      }
+
+      // Step by step, each step costs one addition per edge
+      const std::size_t size = graph.stateCount + (upTo ? 1 : 0);
+      std::size_t bits = 0;
+      for (std::size_t steps = length + 1; steps != 0; steps >>= 1) {
+        ++bits;
+      }
+      const double stepCost = static_cast<double>(length) * static_cast<double>(graph.edges.size() + graph.stateCount);
+      const double squaringCost = 2.0 * static_cast<double>(bits) * static_cast<double>(size) * static_cast<double>(size) * static_cast<double>(size);
+      if (stepCost <= squaringCost) {
+        std::vector<std::uint64_t> current(graph.stateCount, 0);
+        current[graph.initial] = 1;
+        std::uint64_t total = 0;
+        for (std::size_t step = 0; ; ++step) {
+          if (upTo || step == length) {
+            for (std::size_t state = 1; state < graph.stateCount; ++state) {
+              if (graph.finals[state]) {
+                total = addModulo(total, current[state], modulus);
+              }
+            }
+          }
+          if (step == length) {
+            return total;
+          }
+          std::vector<std::uint64_t> next(graph.stateCount, 0);
+          for (const auto& edge : graph.edges) {
+            next[edge.second] = addModulo(next[edge.second], current[edge.first], modulus);
+          }
+          current = std::move(next);
+        }
+      }
+
+      // The matrix counts the edges between the states; to count up to the length, an
+      // extra state sums the final states of each step, so it needs one more step
+      using Matrix = std::vector<std::uint64_t>;
+      Matrix matrix(size * size, 0);
+      for (const auto& edge : graph.edges) {
+        std::uint64_t& cell = matrix[edge.first * size + edge.second];
+        cell = addModulo(cell, 1, modulus);
+      }
+      if (upTo) {
+        for (std::size_t state = 1; state < graph.stateCount; ++state) {
+          matrix[state * size + graph.stateCount] = graph.finals[state];
+        }
+        matrix[size * size - 1] = 1;
+      }
+
+      auto multiply = [size, modulus](const Matrix& lhs, const Matrix& rhs, std::size_t rows) {
+        Matrix product(rows * size, 0);
+        for (std::size_t i = 0; i < rows; ++i) {
+          for (std::size_t k = 0; k < size; ++k) {
+            const std::uint64_t factor = lhs[i * size + k];
+            if (factor == 0) {
+              continue;
+            }
+            for (std::size_t j = 0; j < size; ++j) {
+              product[i * size + j] = addModulo(product[i * size + j], multiplyModulo(factor, rhs[k * size + j], modulus), modulus);
+            }
+          }
+        }
+        return product;
+      };
+
+      Matrix counts(size, 0);
+      counts[graph.initial] = 1;
+      for (std::size_t steps = upTo ? length + 1 : length; steps != 0; steps >>= 1) {
+        if (steps & 1) {
+          counts = multiply(counts, matrix, 1);
+        }
+        if (steps > 1) {
+          matrix = multiply(matrix, matrix, size);
+        }
+      }
+
+      if (upTo) {
+        return counts[graph.stateCount];
+      }
+      std::uint64_t total = 0;
+      for (std::size_t state = 1; state < graph.stateCount; ++state) {
+        if (graph.finals[state]) {
+          total = addModulo(total, counts[state], modulus);
+        }
+      }
+      return total;
+    }
+
+  }
+
+  std::string Automaton::countWords(std::size_t length) const {
+    return countExactly(makeCountingGraph(CompiledAutomaton(*this)), length, false);
+  }
+
+  std::uint64_t Automaton::countWords(std::size_t length, std::uint64_t modulus) const {
+    return countModulo(makeCountingGraph(CompiledAutomaton(*this)), length, modulus, false);
+  }
+
+  std::string Automaton::countWordsUpTo(std::size_t length) const {
+    return countExactly(makeCountingGraph(CompiledAutomaton(*this)), length, true);
+  }
+
+  std::uint64_t Automaton::countWordsUpTo(std::size_t length, std::uint64_t modulus) const {
+    return countModulo(makeCountingGraph(CompiledAutomaton(*this)), length, modulus, true);
+  }
+
+  namespace {
+
+    /**
+     * List the transitions of each live state of a compiled automaton, in byte order
+     */
+    void collectEdges(const CompiledAutomaton& compiled, std::vector<std::size_t>& starts, std::vector<char>& symbols, std::vector<std::uint32_t>& targets) {
+      for (std::uint32_t state = 0; state < compiled.countStates(); ++state) {
+        starts.push_back(symbols.size());
+        for (std::size_t byte = 0; byte < 256 && state != 0; ++byte) {
+          const std::uint32_t target = compiled.next(state, static_cast<char>(byte));
+          if (target != 0) {
+            symbols.push_back(static_cast<char>(byte));
+            targets.push_back(target);
+          }
+        }
+      }
+      starts.push_back(symbols.size());
+    }
+
+  }
+
+  WordSampler::WordSampler(const Automaton& automaton, std::size_t length)
+  : length(length), stateCount(0), initial(0), edgeStarts(), edgeSymbols(), edgeTargets(), mantissas(), exponents() {
+    const CompiledAutomaton compiled(automaton);
+    stateCount = compiled.countStates();
+    initial = compiled.getInitialState();
+    collectEdges(compiled, edgeStarts, edgeSymbols, edgeTargets);
+
+    // Each count is kept as a mantissa and an exponent, the sums are made relative to the largest term
+    mantissas.assign((length + 1) * stateCount, 0.0);
+    exponents.assign((length + 1) * stateCount, 0);
+    for (std::uint32_t state = 1; state < stateCount; ++state) {
+      mantissas[state] = compiled.isStateFinal(state) ? 0.5 : 0.0;
+      exponents[state] = 1;
+    }
+    for (std::size_t remaining = 1; remaining <= length; ++remaining) {
+      const std::size_t previous = (remaining - 1) * stateCount;
+      const std::size_t current = remaining * stateCount;
+      for (std::uint32_t state = 1; state < stateCount; ++state) {
+        const std::size_t begin = edgeStarts[state];
+        const std::size_t end = edgeStarts[state + 1];
+        const int largest = scaleOf(previous, begin, end);
+        double sum = 0.0;
+        for (std::size_t edge = begin; edge < end; ++edge) {
+          const std::size_t target = previous + edgeTargets[edge];
+          if (mantissas[target] > 0.0) {
+            sum += std::ldexp(mantissas[target], exponents[target] - largest);
+          }
+        }
+        int shift = 0;
+        mantissas[current + state] = std::frexp(sum, &shift);
+        exponents[current + state] = largest + shift;
+      }
+    }
+  }
+
+  int WordSampler::scaleOf(std::size_t layer, std::size_t begin, std::size_t end) const {
+    int largest = std::numeric_limits<int>::min();
+    for (std::size_t edge = begin; edge < end; ++edge) {
+      const std::size_t target = layer + edgeTargets[edge];
+      if (mantissas[target] > 0.0) {
+        largest = std::max(largest, exponents[target]);
+      }
+    }
+    return largest == std::numeric_limits<int>::min() ? 0 : largest;
+  }
+
+  std::size_t WordSampler::getLength() const {
+    return length;
+  }
+
+  bool WordSampler::isEmpty() const {
+    return initial == 0 || mantissas[length * stateCount + initial] == 0.0;
+  }
+
+  std::string WordSampler::sample(std::mt19937_64& generator) const {
+    std::string word;
+    word.reserve(length);
+    std::uint32_t state = initial;
+    std::vector<double> weights;
+    for (std::size_t remaining = length; remaining > 0; --remaining) {
+      // The weights of the targets relative to the largest one, so that at least one is not 0
+      const std::size_t next = (remaining - 1) * stateCount;
+      const std::size_t begin = edgeStarts[state];
+      const std::size_t end = edgeStarts[state + 1];
+      const int largest = scaleOf(next, begin, end);
+      weights.assign(end - begin, 0.0);
+      double total = 0.0;
+      for (std::size_t edge = begin; edge < end; ++edge) {
+        const std::size_t target = next + edgeTargets[edge];
+        if (mantissas[target] > 0.0) {
+          weights[edge - begin] = std::ldexp(mantissas[target], exponents[target] - largest);
+          total += weights[edge - begin];
+        }
+      }
+      double draw = std::uniform_real_distribution<double>(0.0, total)(generator);
+      // The last edge with a word absorbs the rounding errors
+      std::size_t chosen = end;
+      for (std::size_t edge = begin; edge < end; ++edge) {
+        if (weights[edge - begin] > 0.0) {
+          chosen = edge;
+          draw -= weights[edge - begin];
+          if (draw < 0.0) {
+            break;
+          }
+        }
+      }
+      if (chosen == end) {
+        return word;
+      }
+      word.push_back(edgeSymbols[chosen]);
+      state = edgeTargets[chosen];
+    }
+    return word;
+  }
+
+  std::vector<std::string> WordSampler::sampleBatch(std::size_t count, std::uint64_t seed, unsigned threads) const {
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(resolveThreadCount(threads), count)));
+    std::vector<std::string> words(count);
+    runOnThreads(threads, [this, &words, count, seed, threads](unsigned index) {
+      std::seed_seq sequence = { static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32), index };
+      std::mt19937_64 generator(sequence);
+      const std::size_t begin = count * index / threads;
+      const std::size_t end = count * (index + 1) / threads;
+      for (std::size_t i = begin; i < end; ++i) {
+        words[i] = sample(generator);
+      }
+    });
+    return words;
+  }
+
+  WordEnumerator::Iterator::Iterator(WordEnumerator* enumerator)
+  : enumerator(enumerator) {
+  }
+
+  std::string_view WordEnumerator::Iterator::operator*() const {
+    return enumerator->getWord();
+  }
+
+  WordEnumerator::Iterator& WordEnumerator::Iterator::operator++() {
+    if (!enumerator->next()) {
+      enumerator = nullptr;
+    }
+    return *this;
+  }
+
+  bool WordEnumerator::Iterator::operator==(const Iterator& other) const {
+    return enumerator == other.enumerator;
+  }
+
+  bool WordEnumerator::Iterator::operator!=(const Iterator& other) const {
+    return enumerator != other.enumerator;
+  }
+
+  WordEnumerator::WordEnumerator(const Automaton& automaton, const WordEnumeratorOptions& options)
+  : edgeStarts(), edgeSymbols(), edgeTargets(), finals(), reachable(), start(0), prefixLength(options.prefix.size()), maxLength(options.maxLength),
+    length(0), started(false), finished(false), states(), choices(), word(options.prefix) {
+    const CompiledAutomaton compiled(automaton);
+    collectEdges(compiled, edgeStarts, edgeSymbols, edgeTargets);
+    for (std::uint32_t state = 0; state < compiled.countStates(); ++state) {
+      finals.push_back(compiled.isStateFinal(state));
+    }
+
+    start = compiled.getInitialState();
+    for (const char c : options.prefix) {
+      start = compiled.next(start, c);
+    }
+    if (start == 0 || prefixLength > maxLength) {
+      finished = true;
+      return;
+    }
+
+    // Without a cycle after the prefix, no word is longer than the prefix and a path through all the states
+    std::vector<std::uint8_t> colors(finals.size(), 0);
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack = { { start, edgeStarts[start] } };
+    colors[start] = 1;
+    bool cyclic = false;
+    while (!stack.empty() && !cyclic) {
+      auto& top = stack.back();
+      if (top.second == edgeStarts[top.first + 1]) {
+        colors[top.first] = 2;
+        stack.pop_back();
+        continue;
+      }
+      const std::uint32_t target = edgeTargets[top.second++];
+      if (colors[target] == 1) {
+        cyclic = true;
+      } else if (colors[target] == 0) {
+        colors[target] = 1;
+        stack.emplace_back(target, edgeStarts[target]);
+      }
+    }
+    if (!cyclic) {
+      maxLength = std::min(maxLength, prefixLength + finals.size());
+    }
+
+    reachable.push_back(finals);
+  }
+
+  std::size_t WordEnumerator::findEdge(std::uint32_t state, std::size_t from, std::size_t remaining) {
+    while (reachable.size() <= remaining) {
+      const std::vector<std::uint8_t>& previous = reachable.back();
+      std::vector<std::uint8_t> current(finals.size(), 0);
+      for (std::uint32_t source = 1; source < finals.size(); ++source) {
+        for (std::size_t edge = edgeStarts[source]; edge < edgeStarts[source + 1] && !current[source]; ++edge) {
+          current[source] = previous[edgeTargets[edge]];
+        }
+      }
+      reachable.push_back(std::move(current));
+    }
+    const std::vector<std::uint8_t>& targets = reachable[remaining];
+    for (std::size_t edge = from; edge < edgeStarts[state + 1]; ++edge) {
+      if (targets[edgeTargets[edge]]) {
+        return edge;
+      }
+    }
+    return edgeStarts[state + 1];
+  }
+
+  void WordEnumerator::descend(std::size_t depth) {
+    const std::size_t total = length - prefixLength;
+    for (; depth < total; ++depth) {
+      const std::size_t edge = findEdge(states[depth], edgeStarts[states[depth]], total - depth - 1);
+      choices[depth] = edge;
+      states[depth + 1] = edgeTargets[edge];
+      word[prefixLength + depth] = edgeSymbols[edge];
+    }
+  }
+
+  bool WordEnumerator::startLength() {
+    const std::size_t total = length - prefixLength;
+    // The first transition towards a word of the remaining length, if any, tells if the length has words
+    if (total == 0) {
+      if (!finals[start]) {
+        return false;
+      }
+    } else if (findEdge(start, edgeStarts[start], total - 1) == edgeStarts[start + 1]) {
+      return false;
+    }
+    states.assign(total + 1, start);
+    choices.assign(total, 0);
+    word.resize(length);
+    descend(0);
+    return true;
+  }
+
+  bool WordEnumerator::advance() {
+    const std::size_t total = length - prefixLength;
+    for (std::size_t depth = total; depth-- > 0;) {
+      const std::size_t edge = findEdge(states[depth], choices[depth] + 1, total - depth - 1);
+      if (edge != edgeStarts[states[depth] + 1]) {
+        choices[depth] = edge;
+        states[depth + 1] = edgeTargets[edge];
+        word[prefixLength + depth] = edgeSymbols[edge];
+        descend(depth + 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool WordEnumerator::next() {
+    if (finished) {
+      return false;
+    }
+    if (!started) {
+      started = true;
+      length = prefixLength;
+      if (startLength()) {
+        return true;
+      }
+    } else if (advance()) {
+      return true;
+    }
+    while (length < maxLength) {
+      ++length;
+      if (startLength()) {
+        return true;
+      }
+    }
+    finished = true;
+    return false;
+  }
+
+  std::string_view WordEnumerator::getWord() const {
+    return word;
+  }
+
+  WordEnumerator::Iterator WordEnumerator::begin() {
+    return Iterator(next() ? this : nullptr);
+  }
+
+  WordEnumerator::Iterator WordEnumerator::end() {
+    return Iterator();
+  }
+
+  namespace {
+
+    /**
+     * A position of a Levenshtein automaton: the characters of the word read and the errors made
+     */
+    using LevenshteinPosition = std::pair<std::size_t, unsigned>;
+
+    /**
+     * Remove the positions subsumed by another one, which accepts all their suffixes
+     */
+    std::vector<LevenshteinPosition> reducePositions(std::vector<LevenshteinPosition> positions) {
+      std::sort(positions.begin(), positions.end());
+      positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+      std::vector<LevenshteinPosition> reduced;
+      for (const LevenshteinPosition& position : positions) {
+        const bool subsumed = std::any_of(positions.begin(), positions.end(), [&position](const LevenshteinPosition& other) {
+          const std::size_t gap = position.first > other.first ? position.first - other.first : other.first - position.first;
+          return other.second < position.second && gap <= position.second - other.second;
+        });
+        if (!subsumed) {
+          reduced.push_back(position);
+        }
+      }
+      return reduced;
+    }
+
+  }
+
+  Automaton Automaton::createLevenshtein(std::string_view word, unsigned maxDistance, std::string_view alphabet) {
+    Automaton levenshtein;
+    for (const char symbol : alphabet) {
+      levenshtein.addSymbol(symbol);
+    }
+    for (const char symbol : word) {
+      levenshtein.addSymbol(symbol);
+    }
+
+    std::map<std::vector<LevenshteinPosition>, int> ids;
+    std::vector<std::vector<LevenshteinPosition>> sets = { { LevenshteinPosition(0, 0) } };
+    ids.emplace(sets.front(), 0);
+    levenshtein.addState(0);
+    levenshtein.setStateInitial(0);
+    for (std::size_t current = 0; current < sets.size(); ++current) {
+      const int state = static_cast<int>(current);
+      // The rest of the word can be deleted
+      for (const LevenshteinPosition& position : sets[current]) {
+        if (word.size() - position.first <= maxDistance - position.second) {
+          levenshtein.setStateFinal(state);
+        }
+      }
+
+      for (const char symbol : levenshtein.symbols) {
+        // Each position may first delete characters of the word, then match, substitute or insert the symbol
+        std::vector<LevenshteinPosition> next;
+        for (const LevenshteinPosition& position : sets[current]) {
+          for (unsigned deleted = 0; position.second + deleted <= maxDistance && position.first + deleted <= word.size(); ++deleted) {
+            const std::size_t index = position.first + deleted;
+            const unsigned errors = position.second + deleted;
+            if (index < word.size() && word[index] == symbol) {
+              next.emplace_back(index + 1, errors);
+            }
+            if (errors < maxDistance) {
+              if (index < word.size()) {
+                next.emplace_back(index + 1, errors + 1);
+              }
+              next.emplace_back(index, errors + 1);
+            }
+          }
+        }
+        if (next.empty()) {
+          continue;
+        }
+        next = reducePositions(std::move(next));
+        const auto inserted = ids.emplace(next, static_cast<int>(sets.size()));
+        if (inserted.second) {
+          levenshtein.addState(inserted.first->second);
+          sets.push_back(std::move(next));
+        }
+        levenshtein.addTransition(state, symbol, inserted.first->second);
+      }
+    }
+    return levenshtein;
+  }
+
+  std::vector<std::string> Automaton::intersectFuzzy(const Automaton& dictionary, std::string_view word, unsigned maxDistance) {
+    std::vector<std::string> matches;
+    const CompiledAutomaton words(dictionary);
+    const std::string alphabet(dictionary.symbols.begin(), dictionary.symbols.end());
+    const CompiledAutomaton levenshtein(createLevenshtein(word, maxDistance, alphabet));
+    if (words.getInitialState() == 0 || levenshtein.getInitialState() == 0) {
+      return matches;
+    }
+
+    std::vector<std::size_t> edgeStarts;
+    std::vector<char> edgeSymbols;
+    std::vector<std::uint32_t> edgeTargets;
+    collectEdges(levenshtein, edgeStarts, edgeSymbols, edgeTargets);
+
+    // Depth-first search on the pairs of states, the Levenshtein automaton has no cycle
+    struct Frame {
+      std::uint32_t wordState;
+      std::uint32_t levenshteinState;
+      std::size_t edge;
+    };
+    std::vector<Frame> stack = { { words.getInitialState(), levenshtein.getInitialState(), edgeStarts[levenshtein.getInitialState()] } };
+    std::string candidate;
+    if (words.isStateFinal(stack.back().wordState) && levenshtein.isStateFinal(stack.back().levenshteinState)) {
+      matches.push_back(candidate);
+    }
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.edge == edgeStarts[frame.levenshteinState + 1]) {
+        stack.pop_back();
+        if (!candidate.empty()) {
+          candidate.pop_back();
+        }
+        continue;
+      }
+      const std::size_t edge = frame.edge++;
+      const std::uint32_t wordState = words.next(frame.wordState, edgeSymbols[edge]);
+      if (wordState == 0) {
+        continue;
+      }
+      const std::uint32_t levenshteinState = edgeTargets[edge];
+      candidate.push_back(edgeSymbols[edge]);
+      if (words.isStateFinal(wordState) && levenshtein.isStateFinal(levenshteinState)) {
+        matches.push_back(candidate);
+      }
+      stack.push_back({ wordState, levenshteinState, edgeStarts[levenshteinState] });
+    }
+    return matches;
+  }
+
+  bool Automaton::exploreProduct(const std::vector<const Automaton*>& automata, Automaton* product) {
+    // Only the symbols shared by every automaton can be read in the product
+    std::vector<char> shared;
+    std::array<int, 256> symbolIndices;
+    symbolIndices.fill(-1);
+    if (!automata.empty()) {
+      for (const char symbol : automata.front()->symbols) {
+        auto hasSymbol = [symbol](const Automaton* automaton) { return automaton->hasSymbol(symbol); };
+        if (std::all_of(automata.begin() + 1, automata.end(), hasSymbol)) {
+          symbolIndices[static_cast<unsigned char>(symbol)] = static_cast<int>(shared.size());
+          shared.push_back(symbol);
+        }
+      }
+    }
+    const std::size_t symbolCount = shared.size();
+
+    // Number the states of each automaton densely and keep only the co-accessible ones
+    struct Component {
+      std::vector<bool> isFinal;
+      std::vector<std::uint32_t> initials;
+      // successors[state * symbolCount + symbol] are the co-accessible arrivals
+      std::vector<std::vector<std::uint32_t>> successors;
+    };
+    std::vector<Component> components(automata.size());
+    bool hasInitials = !automata.empty();
+    for (std::size_t i = 0; i < automata.size(); ++i) {
+      const Automaton& automaton = *automata[i];
+      Component& component = components[i];
+      const std::size_t stateCount = automaton.states.size();
+
+      std::unordered_map<int, std::uint32_t> numbers;
+      numbers.reserve(stateCount);
+      for (const auto& state : automaton.states) {
+        numbers.emplace(state.first, static_cast<std::uint32_t>(numbers.size()));
+      }
+
+      std::vector<std::vector<std::uint32_t>> predecessors(stateCount);
+      std::vector<bool> coAccessible(stateCount, false);
+      std::vector<std::uint32_t> queue;
+      component.isFinal.assign(stateCount, false);
+      for (const auto& state : automaton.states) {
+        const std::uint32_t from = numbers.at(state.first);
+        component.isFinal[from] = state.second.isFinal;
+        if (state.second.isFinal) {
+          coAccessible[from] = true;
+          queue.push_back(from);
+        }
+        for (const auto& symbol : state.second.transitions) {
+          if (symbolIndices[static_cast<unsigned char>(symbol.first)] < 0) {
+            continue;
+          }
+          for (const int arrival : symbol.second) {
+            predecessors[numbers.at(arrival)].push_back(from);
+          }
+        }
+      }
+      for (std::size_t next = 0; next < queue.size(); ++next) {
+        for (const std::uint32_t predecessor : predecessors[queue[next]]) {
+          if (!coAccessible[predecessor]) {
+            coAccessible[predecessor] = true;
+            queue.push_back(predecessor);
+          }
+        }
+      }
+
+      component.successors.resize(stateCount * symbolCount);
+      for (const auto& state : automaton.states) {
+        const std::uint32_t from = numbers.at(state.first);
+        if (!coAccessible[from]) {
+          continue;
+        }
+        if (state.second.isInitial) {
+          component.initials.push_back(from);
+        }
+        for (const auto& symbol : state.second.transitions) {
+          const int index = symbolIndices[static_cast<unsigned char>(symbol.first)];
+          if (index < 0) {
+            continue;
+          }
+          for (const int arrival : symbol.second) {
+            if (coAccessible[numbers.at(arrival)]) {
+              component.successors[from * symbolCount + index].push_back(numbers.at(arrival));
+            }
+          }
+        }
+      }
+      hasInitials = hasInitials && !component.initials.empty();
+    }
+
+    // Visit every tuple taking one state in each list, like an odometer
+    auto forEachTuple = [](const std::vector<const std::vector<std::uint32_t>*>& choices, Subset& tuple, auto&& visit) {
+      std::vector<std::size_t> positions(choices.size(), 0);
+      for (std::size_t i = 0; i < choices.size(); ++i) {
+        tuple[i] = (*choices[i])[0];
+      }
+      while (true) {
+        if (!visit()) {
+          return false;
+        }
+        std::size_t i = 0;
+        while (i < choices.size() && ++positions[i] == choices[i]->size()) {
+          positions[i] = 0;
+          tuple[i] = (*choices[i])[0];
+          ++i;
+        }
+        if (i == choices.size()) {
+          return true;
+        }
+        tuple[i] = (*choices[i])[positions[i]];
+      }
+    };
+
+    struct Edge {
+      std::uint32_t from;
+      std::uint32_t symbol;
+      std::uint32_t to;
+    };
+    std::unordered_map<Subset, std::uint32_t, SubsetHash> numbers;
+    std::vector<const Subset*> order;
+    std::vector<bool> finals;
+    std::vector<Edge> edges;
+    bool foundFinal = false;
+    Subset tuple(automata.size());
+
+    // Give a number to the current tuple; returns false to stop the search
+    std::uint32_t arrival = 0;
+    auto discover = [&]() {
+      auto inserted = numbers.emplace(tuple, static_cast<std::uint32_t>(order.size()));
+      arrival = inserted.first->second;
+      if (inserted.second) {
+        order.push_back(&inserted.first->first);
+        bool isFinal = true;
+        for (std::size_t i = 0; i < tuple.size() && isFinal; ++i) {
+          isFinal = components[i].isFinal[tuple[i]];
+        }
+        finals.push_back(isFinal);
+        foundFinal = foundFinal || isFinal;
+      }
+      return product != nullptr || !foundFinal;
+    };
+
+    std::size_t initialCount = 0;
+    if (hasInitials) {
+      std::vector<const std::vector<std::uint32_t>*> choices;
+      for (const Component& component : components) {
+        choices.push_back(&component.initials);
+      }
+      if (!forEachTuple(choices, tuple, discover)) {
+        return true;
+      }
+      initialCount = order.size();
+    }
+
+    std::vector<const std::vector<std::uint32_t>*> choices(automata.size());
+    for (std::uint32_t current = 0; current < order.size(); ++current) {
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        bool hasArrivals = true;
+        for (std::size_t i = 0; i < automata.size() && hasArrivals; ++i) {
+          choices[i] = &components[i].successors[(*order[current])[i] * symbolCount + symbol];
+          hasArrivals = !choices[i]->empty();
+        }
+        if (!hasArrivals) {
+          continue;
+        }
+        auto visit = [&]() {
+          const bool proceed = discover();
+          edges.push_back(Edge{ current, static_cast<std::uint32_t>(symbol), arrival });
+          return proceed;
+        };
+        if (!forEachTuple(choices, tuple, visit)) {
+          return true;
+        }
+      }
+    }
+
+    if (product == nullptr) {
+      return foundFinal;
+    }
+
+    // Remove the tuples that cannot reach a final tuple, keeping the discovery order
+    const std::size_t tupleCount = order.size();
+    std::vector<std::vector<std::uint32_t>> predecessors(tupleCount);
+    for (const Edge& edge : edges) {
+      predecessors[edge.to].push_back(edge.from);
+    }
+    std::vector<bool> coAccessible(finals);
+    std::vector<std::uint32_t> queue;
+    for (std::uint32_t current = 0; current < tupleCount; ++current) {
+      if (finals[current]) {
+        queue.push_back(current);
+      }
+    }
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+      for (const std::uint32_t predecessor : predecessors[queue[next]]) {
+        if (!coAccessible[predecessor]) {
+          coAccessible[predecessor] = true;
+          queue.push_back(predecessor);
+        }
+      }
+    }
+
+    std::vector<int> renumbered(tupleCount, -1);
+    std::vector<State> states;
+    for (std::uint32_t current = 0; current < tupleCount; ++current) {
+      if (coAccessible[current]) {
+        renumbered[current] = static_cast<int>(states.size());
+        states.emplace_back(product->states.get_allocator());
+        states.back().state = renumbered[current];
+        states.back().isInitial = current < initialCount;
+        states.back().isFinal = finals[current];
+      }
+    }
+    for (const Edge& edge : edges) {
+      if (renumbered[edge.from] >= 0 && renumbered[edge.to] >= 0) {
+        states[renumbered[edge.from]].transitions[shared[edge.symbol]].insert(renumbered[edge.to]);
+      }
+    }
+
+    product->symbols.insert(shared.begin(), shared.end());
+    if (shared.empty()) {
+      product->addSymbol('a');
+    }
+    for (State& state : states) {
+      product->states.emplace_hint(product->states.end(), state.state, std::move(state));
+    }
+    if (product->states.empty()) {
+      product->addState(0);
+    }
+    return foundFinal;
+  }
+
+  Automaton Automaton::createIntersection(const std::vector<const Automaton*>& automata) {
+    Automaton product(automata.empty() ? std::pmr::get_default_resource() : automata.front()->getMemoryResource());
+    exploreProduct(automata, &product);
+    return product;
+  }
+
+  bool Automaton::hasEmptyIntersection(const std::vector<const Automaton*>& automata) {
+    return !exploreProduct(automata, nullptr);
+  }
+
+  namespace {
+
+    /**
+     * Square matrix of bits, with a row of 64-bit words per state
+     */
+    class BitMatrix {
+    public:
+      explicit BitMatrix(std::size_t size)
+      : words((size + 63) / 64), bits(size * words, 0) {}
+
+      bool test(std::size_t row, std::size_t column) const {
+        return (bits[row * words + column / 64] >> (column % 64)) & 1;
+      }
+
+      void set(std::size_t row, std::size_t column) {
+        bits[row * words + column / 64] |= std::uint64_t(1) << (column % 64);
+      }
+
+      void reset(std::size_t row, std::size_t column) {
+        bits[row * words + column / 64] &= ~(std::uint64_t(1) << (column % 64));
+      }
+
+      /**
+       * Call a function with each column set in a row, in increasing order
+       */
+      template<typename Function>
+      void forEach(std::size_t row, Function function) const {
+        for (std::size_t word = 0; word < words; ++word) {
+          for (std::uint64_t remaining = bits[row * words + word]; remaining != 0; remaining &= remaining - 1) {
+            function(word * 64 + static_cast<std::size_t>(__builtin_ctzll(remaining)));
+          }
+        }
+      }
+
+    private:
+      std::size_t words;
+      std::vector<std::uint64_t> bits;
+    };
+
+  }
+
+  void Automaton::reduceBySimulation() {
+    // Number the states and the symbols densely, epsilon included
+    const std::size_t stateCount = states.size();
+    std::vector<int> originals;
+    std::unordered_map<int, std::uint32_t> numbers;
+    originals.reserve(stateCount);
+    numbers.reserve(stateCount);
+    for (const auto& state : states) {
+      numbers.emplace(state.first, static_cast<std::uint32_t>(originals.size()));
+      originals.push_back(state.first);
+    }
+    std::array<int, 256> symbolIndices;
+    symbolIndices.fill(-1);
+    std::vector<char> alphabet;
+    for (const auto& state : states) {
+      for (const auto& symbol : state.second.transitions) {
+        int& index = symbolIndices[static_cast<unsigned char>(symbol.first)];
+        if (index < 0) {
+          index = static_cast<int>(alphabet.size());
+          alphabet.push_back(symbol.first);
+        }
+      }
+    }
+    const std::size_t symbolCount = alphabet.size();
+
+    // successors[state * symbolCount + symbol], and the same transitions backwards in predecessors
+    std::vector<std::vector<std::uint32_t>> successors(stateCount * symbolCount);
+    std::vector<std::vector<std::uint32_t>> predecessors(stateCount * symbolCount);
+    std::vector<bool> isFinal(stateCount);
+    for (const auto& state : states) {
+      const std::uint32_t from = numbers.at(state.first);
+      isFinal[from] = state.second.isFinal;
+      for (const auto& symbol : state.second.transitions) {
+        const std::size_t index = static_cast<std::size_t>(symbolIndices[static_cast<unsigned char>(symbol.first)]);
+        for (const int arrival : symbol.second) {
+          successors[from * symbolCount + index].push_back(numbers.at(arrival));
+          predecessors[numbers.at(arrival) * symbolCount + index].push_back(from);
+        }
+      }
+    }
+
+    // The pairs of a state and a symbol it reads, and the pairs leading to each state
+    std::vector<std::uint32_t> pairStates;
+    std::vector<std::uint32_t> pairSymbols;
+    std::vector<std::vector<std::uint32_t>> readSymbols(stateCount);
+    std::vector<std::vector<std::uint32_t>> incomingPairs(stateCount);
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      for (std::uint32_t symbol = 0; symbol < symbolCount; ++symbol) {
+        const std::vector<std::uint32_t>& arrivals = successors[q * symbolCount + symbol];
+        if (arrivals.empty()) {
+          continue;
+        }
+        readSymbols[q].push_back(symbol);
+        for (const std::uint32_t arrival : arrivals) {
+          incomingPairs[arrival].push_back(static_cast<std::uint32_t>(pairStates.size()));
+        }
+        pairStates.push_back(q);
+        pairSymbols.push_back(symbol);
+      }
+    }
+    const std::size_t pairCount = pairStates.size();
+
+    // simulated.test(q, r) while r may simulate q: r is final if q is and reads every symbol q reads
+    BitMatrix simulated(stateCount);
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      for (std::uint32_t r = 0; r < stateCount; ++r) {
+        auto reads = [&](std::uint32_t symbol) { return !successors[r * symbolCount + symbol].empty(); };
+        if ((!isFinal[q] || isFinal[r]) && std::all_of(readSymbols[q].begin(), readSymbols[q].end(), reads)) {
+          simulated.set(q, r);
+        }
+      }
+    }
+
+    // Henzinger, Henzinger and Kopke refinement, in O(n * m):
+    // counts[pair * stateCount + q] is the number of arrivals of the pair that may simulate q, and
+    // removes[q * symbolCount + symbol] the states reading the symbol with no such arrival, which
+    // cannot simulate the predecessors of q by the symbol
+    std::vector<std::uint32_t> counts(pairCount * stateCount, 0);
+    std::vector<std::vector<std::uint32_t>> removes(stateCount * symbolCount);
+    std::vector<std::size_t> worklist;
+    for (std::size_t pair = 0; pair < pairCount; ++pair) {
+      const std::vector<std::uint32_t>& arrivals = successors[pairStates[pair] * symbolCount + pairSymbols[pair]];
+      for (std::uint32_t q = 0; q < stateCount; ++q) {
+        auto simulates = [&](std::uint32_t arrival) { return simulated.test(q, arrival); };
+        const std::uint32_t count = static_cast<std::uint32_t>(std::count_if(arrivals.begin(), arrivals.end(), simulates));
+        counts[pair * stateCount + q] = count;
+        if (count == 0) {
+          std::vector<std::uint32_t>& remove = removes[q * symbolCount + pairSymbols[pair]];
+          if (remove.empty()) {
+            worklist.push_back(q * symbolCount + pairSymbols[pair]);
+          }
+          remove.push_back(pairStates[pair]);
+        }
+      }
+    }
+    std::vector<std::uint32_t> removed;
+    while (!worklist.empty()) {
+      const std::size_t index = worklist.back();
+      worklist.pop_back();
+      removed.clear();
+      removed.swap(removes[index]);
+      for (const std::uint32_t predecessor : predecessors[index]) {
+        for (const std::uint32_t candidate : removed) {
+          if (!simulated.test(predecessor, candidate)) {
+            continue;
+          }
+          simulated.reset(predecessor, candidate);
+          // The pairs leading to the candidate have one arrival less simulating the predecessor
+          for (const std::uint32_t pair : incomingPairs[candidate]) {
+            if (--counts[pair * stateCount + predecessor] == 0) {
+              std::vector<std::uint32_t>& remove = removes[predecessor * symbolCount + pairSymbols[pair]];
+              if (remove.empty()) {
+                worklist.push_back(predecessor * symbolCount + pairSymbols[pair]);
+              }
+              remove.push_back(pairStates[pair]);
+            }
+          }
+        }
+      }
+    }
+
+    // Merge the states simulating each other into the first of them
+    std::vector<std::uint32_t> classes(stateCount);
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      classes[q] = q;
+      for (std::uint32_t r = 0; r < q; ++r) {
+        if (classes[r] == r && simulated.test(q, r) && simulated.test(r, q)) {
+          classes[q] = r;
+          break;
+        }
+      }
+    }
+    std::vector<bool> isInitial(stateCount, false);
+    std::vector<std::vector<std::uint32_t>> merged(stateCount * symbolCount);
+    for (const auto& state : states) {
+      const std::uint32_t from = classes[numbers.at(state.first)];
+      isInitial[from] = isInitial[from] || state.second.isInitial;
+    }
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        std::vector<std::uint32_t>& targets = merged[classes[q] * symbolCount + symbol];
+        for (const std::uint32_t arrival : successors[q * symbolCount + symbol]) {
+          targets.push_back(classes[arrival]);
+        }
+      }
+    }
+
+    // Drop the little brothers: the targets simulated by another target of the same transitions
+    auto keepBiggest = [&simulated](std::vector<std::uint32_t>& targets) {
+      std::sort(targets.begin(), targets.end());
+      targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+      std::vector<std::uint32_t> kept;
+      for (const std::uint32_t target : targets) {
+        auto isBigger = [&](std::uint32_t other) { return other != target && simulated.test(target, other); };
+        if (std::none_of(targets.begin(), targets.end(), isBigger)) {
+          kept.push_back(target);
+        }
+      }
+      targets = std::move(kept);
+    };
+    for (std::vector<std::uint32_t>& targets : merged) {
+      keepBiggest(targets);
+    }
+    std::vector<std::uint32_t> initials;
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      if (isInitial[q]) {
+        initials.push_back(q);
+      }
+    }
+    keepBiggest(initials);
+
+    // Keep the accessible states, under their first original number
+    std::vector<bool> accessible(stateCount, false);
+    std::vector<std::uint32_t> queue(initials);
+    for (const std::uint32_t initial : initials) {
+      accessible[initial] = true;
+    }
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        for (const std::uint32_t arrival : merged[queue[next] * symbolCount + symbol]) {
+          if (!accessible[arrival]) {
+            accessible[arrival] = true;
+            queue.push_back(arrival);
+          }
+        }
+      }
+    }
+
+    std::pmr::map<int, State> reduced(states.get_allocator());
+    std::fill(isInitial.begin(), isInitial.end(), false);
+    for (const std::uint32_t initial : initials) {
+      isInitial[initial] = true;
+    }
+    for (std::uint32_t q = 0; q < stateCount; ++q) {
+      if (!accessible[q]) {
+        continue;
+      }
+      State state(states.get_allocator());
+      state.state = originals[q];
+      state.isInitial = isInitial[q];
+      state.isFinal = isFinal[q];
+      for (std::size_t symbol = 0; symbol < symbolCount; ++symbol) {
+        const std::vector<std::uint32_t>& targets = merged[q * symbolCount + symbol];
+        if (!targets.empty()) {
+          std::pmr::set<int>& arrivals = state.transitions[alphabet[symbol]];
+          for (const std::uint32_t arrival : targets) {
+            arrivals.insert(originals[arrival]);
+          }
+        }
+      }
+      reduced.emplace_hint(reduced.end(), state.state, std::move(state));
+    }
+    states = std::move(reduced);
+
+    if (states.empty()) {
+      addState(0);
+    }
+  }
+
+  namespace {
+
+    /**
+     * Partition of the states in blocks, split by marking some of their states
+     *
+     * The states of a block are contiguous in a single array, and the marked
+     * ones are moved to the front of their block.
+     */
+    class RefinablePartition {
+    public:
+      explicit RefinablePartition(std::size_t size)
+      : elements(size), locations(size), blockOf(size, 0), blocks(1, Block{ 0, static_cast<std::uint32_t>(size), 0 }), touched() {
+        for (std::uint32_t element = 0; element < size; ++element) {
+          elements[element] = element;
+          locations[element] = element;
+        }
+      }
+
+      std::size_t countBlocks() const {
+        return blocks.size();
+      }
+
+      std::uint32_t getBlock(std::uint32_t element) const {
+        return blockOf[element];
+      }
+
+      std::size_t getSize(std::uint32_t block) const {
+        return blocks[block].end - blocks[block].first;
+      }
+
+      const std::uint32_t* begin(std::uint32_t block) const {
+        return elements.data() + blocks[block].first;
+      }
+
+      const std::uint32_t* end(std::uint32_t block) const {
+        return elements.data() + blocks[block].end;
+      }
+
+      void mark(std::uint32_t element) {
+        Block& block = blocks[blockOf[element]];
+        const std::uint32_t location = locations[element];
+        if (location < block.marked) {
+          return;
+        }
+        if (block.marked == block.first) {
+          touched.push_back(blockOf[element]);
+        }
+        const std::uint32_t other = elements[block.marked];
+        std::swap(elements[location], elements[block.marked]);
+        locations[other] = location;
+        locations[element] = block.marked++;
+      }
+
+      /**
+       * Split the marked states of each block into a new block, if not the whole block
+       *
+       * The new block is given to the callback along with the block it comes from.
+       */
+      template<typename Callback>
+      void split(Callback callback) {
+        for (const std::uint32_t index : touched) {
+          Block& block = blocks[index];
+          const std::uint32_t marked = block.marked;
+          block.marked = block.first;
+          if (marked == block.end) {
+            continue;
+          }
+          const std::uint32_t created = static_cast<std::uint32_t>(blocks.size());
+          const std::uint32_t first = block.first;
+          block.first = marked;
+          block.marked = marked;
+          blocks.push_back(Block{ first, marked, first });
+          for (std::uint32_t location = first; location < marked; ++location) {
+            blockOf[elements[location]] = created;
+          }
+          callback(index, created);
+        }
+        touched.clear();
+      }
+
+    private:
+      struct Block {
+        std::uint32_t first;
+        std::uint32_t end;
+        std::uint32_t marked;
+      };
+
+      std::vector<std::uint32_t> elements;
+      std::vector<std::uint32_t> locations;
+      std::vector<std::uint32_t> blockOf;
+      std::vector<Block> blocks;
+      std::vector<std::uint32_t> touched;
+    };
+
+  }
+
+  void Automaton::reduceByBisimulation() {
+    if (states.empty()) {
+      return;
+    }
+    const std::size_t stateCount = states.size();
+    std::vector<int> originals;
+    std::unordered_map<int, std::uint32_t> numbers;
+    originals.reserve(stateCount);
+    numbers.reserve(stateCount);
+    for (const auto& state : states) {
+      numbers.emplace(state.first, static_cast<std::uint32_t>(originals.size()));
+      originals.push_back(state.first);
+    }
+
+    // The transitions are listed by origin and symbol, epsilon included, and
+    // each one refers to the counter of its origin and symbol towards the
+    // compound block holding its arrival
+    struct Edge {
+      std::uint32_t from;
+      char symbol;
+      std::uint32_t to;
+      std::uint32_t counter;
+    };
+    std::vector<Edge> edges;
+    std::vector<std::uint32_t> counters;
+    for (const auto& state : states) {
+      const std::uint32_t from = numbers.at(state.first);
+      for (const auto& symbol : state.second.transitions) {
+        for (const int arrival : symbol.second) {
+          edges.push_back(Edge{ from, symbol.first, numbers.at(arrival), static_cast<std::uint32_t>(counters.size()) });
+        }
+        counters.push_back(static_cast<std::uint32_t>(symbol.second.size()));
+      }
+    }
+    std::vector<std::vector<std::uint32_t>> incoming(stateCount);
+    for (std::uint32_t edge = 0; edge < edges.size(); ++edge) {
+      incoming[edges[edge].to].push_back(edge);
+    }
+
+    // Compound blocks are unions of blocks of the partition, which is stable with respect to each of them
+    RefinablePartition partition(stateCount);
+    std::vector<std::vector<std::uint32_t>> compounds(1);
+    std::vector<std::uint32_t> compoundOf(1, 0);
+    std::vector<std::uint32_t> worklist;
+    std::vector<bool> queued(1, false);
+    auto onSplit = [&](std::uint32_t block, std::uint32_t created) {
+      const std::uint32_t compound = compoundOf[block];
+      compoundOf.push_back(compound);
+      compounds[compound].push_back(created);
+      if (!queued[compound]) {
+        queued[compound] = true;
+        worklist.push_back(compound);
+      }
+    };
+
+    // Start from the final flags and the symbols that can be read, stable with respect to all the states
+    for (const auto& state : states) {
+      if (state.second.isFinal) {
+        partition.mark(numbers.at(state.first));
+      }
+    }
+    partition.split(onSplit);
+
+    // The edges are grouped by symbol with a bucket per byte, without sorting
+    std::array<std::vector<std::uint32_t>, 256> buckets;
+    std::vector<unsigned char> usedSymbols;
+    auto addToBucket = [&](std::uint32_t edge) {
+      const unsigned char symbol = static_cast<unsigned char>(edges[edge].symbol);
+      if (buckets[symbol].empty()) {
+        usedSymbols.push_back(symbol);
+      }
+      buckets[symbol].push_back(edge);
+    };
+
+    for (std::uint32_t edge = 0; edge < edges.size(); ++edge) {
+      addToBucket(edge);
+    }
+    for (const unsigned char symbol : usedSymbols) {
+      for (const std::uint32_t edge : buckets[symbol]) {
+        partition.mark(edges[edge].from);
+      }
+      partition.split(onSplit);
+      buckets[symbol].clear();
+    }
+    usedSymbols.clear();
+    compounds[0].insert(compounds[0].begin(), 0);
+
+    std::vector<std::uint32_t> countsInSplitter(stateCount, 0);
+    std::vector<std::uint32_t> countersInCompound(stateCount, 0);
+    std::vector<std::uint32_t> origins;
+    while (!worklist.empty()) {
+      const std::uint32_t compound = worklist.back();
+      worklist.pop_back();
+      queued[compound] = false;
+      std::vector<std::uint32_t>& members = compounds[compound];
+      if (members.size() < 2) {
+        continue;
+      }
+
+      // Take out the smaller of two blocks of the compound: it has at most half of its states
+      const std::size_t last = members.size() - 1;
+      if (partition.getSize(members[last - 1]) < partition.getSize(members[last])) {
+        std::swap(members[last - 1], members[last]);
+      }
+      const std::uint32_t splitter = members.back();
+      members.pop_back();
+      if (members.size() >= 2) {
+        queued[compound] = true;
+        worklist.push_back(compound);
+      }
+      compoundOf[splitter] = static_cast<std::uint32_t>(compounds.size());
+      compounds.push_back({ splitter });
+      queued.push_back(false);
+
+      for (const std::uint32_t* state = partition.begin(splitter); state != partition.end(splitter); ++state) {
+        for (const std::uint32_t edge : incoming[*state]) {
+          addToBucket(edge);
+        }
+      }
+
+      for (const unsigned char symbol : usedSymbols) {
+        std::vector<std::uint32_t>& splitterEdges = buckets[symbol];
+        origins.clear();
+        for (const std::uint32_t index : splitterEdges) {
+          const Edge& edge = edges[index];
+          if (countsInSplitter[edge.from]++ == 0) {
+            origins.push_back(edge.from);
+            countersInCompound[edge.from] = edge.counter;
+          }
+        }
+
+        // Split with the states reaching the splitter, then with those only reaching it in the compound
+        for (const std::uint32_t origin : origins) {
+          partition.mark(origin);
+        }
+        partition.split(onSplit);
+        for (const std::uint32_t origin : origins) {
+          if (countsInSplitter[origin] == counters[countersInCompound[origin]]) {
+            partition.mark(origin);
+          }
+        }
+        partition.split(onSplit);
+
+        // The transitions to the splitter now count towards its own compound block
+        for (const std::uint32_t origin : origins) {
+          counters[countersInCompound[origin]] -= countsInSplitter[origin];
+          countersInCompound[origin] = static_cast<std::uint32_t>(counters.size());
+          counters.push_back(countsInSplitter[origin]);
+        }
+        for (const std::uint32_t index : splitterEdges) {
+          Edge& edge = edges[index];
+          edge.counter = countersInCompound[edge.from];
+        }
+        for (const std::uint32_t origin : origins) {
+          countsInSplitter[origin] = 0;
+        }
+        splitterEdges.clear();
+      }
+      usedSymbols.clear();
+    }
+
+    // Each block becomes a state numbered as its first state
+    std::vector<int> representatives(partition.countBlocks(), std::numeric_limits<int>::max());
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+      int& representative = representatives[partition.getBlock(state)];
+      representative = std::min(representative, originals[state]);
+    }
+    std::pmr::map<int, State> reduced(states.get_allocator());
+    for (const int representative : representatives) {
+      State& state = reduced.try_emplace(representative).first->second;
+      state.state = representative;
+    }
+    for (const auto& state : states) {
+      State& merged = reduced.at(representatives[partition.getBlock(numbers.at(state.first))]);
+      merged.isInitial = merged.isInitial || state.second.isInitial;
+      merged.isFinal = state.second.isFinal;
+    }
+    for (const Edge& edge : edges) {
+      reduced.at(representatives[partition.getBlock(edge.from)]).transitions[edge.symbol].insert(representatives[partition.getBlock(edge.to)]);
+    }
+    states = std::move(reduced);
+  }
+
+}
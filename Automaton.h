@@ -1,19 +1,44 @@
 #ifndef AUTOMATON_H
 #define AUTOMATON_H
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <random>
 #include <set>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 
 namespace fa {
 
   constexpr char Epsilon = '\0';
 
+  /**
+   * Options of Automaton::generateCpp()
+   */
+  struct CppGeneratorOptions {
+    enum class Style {
+      Goto,   // One label per state and a switch on the next byte
+      Table,  // A static transition table and a loop
+    };
+
+    std::string functionName = "match";
+    Style style = Style::Goto;
+  };
+
   class Automaton {
   public:
     /**
@@ -21,6 +46,31 @@ namespace fa {
      */
     Automaton();
 
+    /**
+     * Build an empty automaton whose states and transitions are allocated
+     * from a memory resource.
+     *
+     * The resource must outlive the automaton and its copies. With a
+     * std::pmr::monotonic_buffer_resource, deallocations are no-ops and the
+     * whole automaton is released at once with the resource.
+     */
+    explicit Automaton(std::pmr::memory_resource* resource);
+
+    /**
+     * Copy an automaton, the copy uses the same memory resource
+     */
+    Automaton(const Automaton& other);
+    Automaton(Automaton&& other) = default;
+    Automaton& operator=(const Automaton& other) = default;
+    Automaton& operator=(Automaton&& other) = default;
+
+    /**
+     * Get the memory resource of the automaton
+     *
+     * The automata created from this one are allocated from the same resource.
+     */
+    std::pmr::memory_resource* getMemoryResource() const;
+
     /**
      * Tell if an automaton is valid.
      *
@@ -129,6 +179,14 @@ namespace fa {
      */
     void prettyPrint(std::ostream& os) const;
 
+    /**
+     * Print a standalone C++ function matching the language of the automaton
+     *
+     * The function takes a std::string_view and implements the minimal
+     * automaton, either with gotos between the states or with a table.
+     */
+    void generateCpp(std::ostream& os, const CppGeneratorOptions& options = CppGeneratorOptions()) const;
+
     /**
      * Print the automaton with respect to the DOT specification
      */
@@ -174,6 +232,31 @@ namespace fa {
      */
     void removeNonCoAccessibleStates();
 
+    /**
+     * Reduce the automaton with its maximal forward simulation
+     *
+     * A state simulates another when it accepts at least its language step
+     * by step. The maximal simulation is computed with the counter-based
+     * refinement of Henzinger, Henzinger and Kopke, in O(n * m). The states
+     * that simulate each other are merged into the one with the smallest
+     * number, the transitions and initial flags leading to a state simulated
+     * by a sibling are removed, and so are the states that become
+     * non-accessible. The language is kept and the automaton stays
+     * nondeterministic: this is meant to be cheap before createDeterministic().
+     */
+    void reduceBySimulation();
+
+    /**
+     * Reduce the automaton by merging its bisimilar states
+     *
+     * Two states are bisimilar when they have the same final flag and each
+     * transition of one is matched by a transition of the other to a
+     * bisimilar state. The coarsest bisimulation is found with Paige-Tarjan
+     * partition refinement in O(m log n), without determinizing, and each
+     * class of states keeps its smallest number.
+     */
+    void reduceByBisimulation();
+
     /**
      * Check if the language of the automaton is empty
      */
@@ -190,20 +273,123 @@ namespace fa {
      */
     bool isIncludedIn(const Automaton& other) const;
 
+    /**
+     * Find a shortest accepted word
+     *
+     * The states are explored in breadth-first order, and the word is rebuilt
+     * from the transition that discovered each state. For a deterministic
+     * automaton, it is the smallest shortest word in alphabetical order. As
+     * in match(), the epsilon-transitions are not followed.
+     * Returns no word if the automaton accepts none.
+     */
+    std::optional<std::string> shortestWord() const;
+
+    /**
+     * Find a shortest word accepted by both automata
+     *
+     * The pairs of states of the product are explored in breadth-first order,
+     * without building the intersection automaton.
+     * Returns no word if the intersection is empty.
+     */
+    std::optional<std::string> findCommonWord(const Automaton& other) const;
+
+    /**
+     * Find a shortest word accepted by this automaton and not by the other one
+     *
+     * The pairs of a state of this automaton and of the subset of states of
+     * the other one reached by the same word are explored in breadth-first
+     * order, without complementing the other automaton. The languages are
+     * compared whatever the alphabets.
+     * Returns no word if the language is included in the other one.
+     */
+    std::optional<std::string> findNotIncludedWord(const Automaton& other) const;
+
+    /**
+     * Count the accepted words of a length
+     *
+     * The automaton is compiled into a deterministic table, then the number
+     * of words reaching each state is computed length after length. The
+     * exact count is returned in decimal.
+     */
+    std::string countWords(std::size_t length) const;
+
+    /**
+     * Count the accepted words of a length, modulo a number
+     *
+     * For long words, the transition matrix is raised to the power of the
+     * length by repeated squaring when it is cheaper than the step by step
+     * computation. A modulus of 0 counts modulo 2^64.
+     */
+    std::uint64_t countWords(std::size_t length, std::uint64_t modulus) const;
+
+    /**
+     * Count the accepted words up to a length (included)
+     */
+    std::string countWordsUpTo(std::size_t length) const;
+    std::uint64_t countWordsUpTo(std::size_t length, std::uint64_t modulus) const;
+
+    /**
+     * Mirror the automaton in place
+     *
+     * The transition nodes are reused instead of being copied.
+     */
+    void mirrorInPlace();
+
+    /**
+     * Make the automaton complete in place, if not already complete
+     */
+    void complete();
+
+    /**
+     * Complement the automaton in place
+     *
+     * The automaton is determinized first if needed, then completed.
+     */
+    void complementInPlace();
+
     /**
      * Create a mirror automaton
      */
     static Automaton createMirror(const Automaton& automaton);
+    static Automaton createMirror(Automaton&& automaton);
 
     /**
      * Create a complete automaton, if not already complete
      */
     static Automaton createComplete(const Automaton& automaton);
+    static Automaton createComplete(Automaton&& automaton);
 
     /**
      * Create a complement automaton
      */
     static Automaton createComplement(const Automaton& automaton);
+    static Automaton createComplement(Automaton&& automaton);
+
+    /**
+     * Create an automaton accepting the union of the languages of two automata
+     *
+     * The states of both automata are renumbered one after the other and
+     * both keep their initial states. As in match(), the epsilon-transitions
+     * of the operands are ignored, and the result has none.
+     */
+    static Automaton createUnion(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create an automaton accepting the concatenation of the languages of two automata
+     *
+     * The final states of lhs get a copy of the transitions of the initial
+     * states of rhs, and stay final only if rhs accepts the empty word. The
+     * result has no epsilon-transition.
+     */
+    static Automaton createConcatenation(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create an automaton accepting the Kleene star of the language of an automaton
+     *
+     * A new initial and final state 0 and the final states get a copy of the
+     * transitions of the initial states. The result has no epsilon-transition.
+     */
+    static Automaton createKleeneStar(const Automaton& automaton);
 
     /**
      * Create the intersection of the languages of two automata
@@ -211,36 +397,256 @@ namespace fa {
     static Automaton createIntersection(const Automaton& lhs, const Automaton& rhs);
 
     /**
-     * Create a deterministic automaton, if not already deterministic
+     * Create the intersection of the languages of several automata at once
+     *
+     * The tuples of states are explored directly, without the intermediate
+     * products of chained pairwise intersections. A tuple is only built when
+     * each of its states can still reach a final state, and the tuples that
+     * cannot reach a final tuple are removed at the end.
+     */
+    static Automaton createIntersection(const std::vector<const Automaton*>& automata);
+
+    /**
+     * Tell if the intersection of several automata is empty
+     *
+     * The product is explored on the fly and the search stops at the first
+     * tuple of final states.
+     */
+    static bool hasEmptyIntersection(const std::vector<const Automaton*>& automata);
+
+    /**
+     * Create a deterministic automaton
+     *
+     * The result is always rebuilt, even from a deterministic automaton and
+     * with both overloads: its states are the accessible subsets, numbered
+     * from 0 in breadth-first order from the initial one.
      */
     static Automaton createDeterministic(const Automaton& other);
+    static Automaton createDeterministic(Automaton&& other);
+
+    /**
+     * Create a deterministic automaton with several threads
+     *
+     * The subsets of the frontier are expanded by a pool of workers sharing a
+     * concurrent table of subsets. The result is renumbered at the end and is
+     * the same as the one of the sequential version, whatever the number of
+     * threads. With 0 threads, the hardware concurrency is used.
+     */
+    static Automaton createDeterministic(const Automaton& other, unsigned threads);
 
     /**
      * Create an equivalent minimal automaton with the Moore algorithm
      */
     static Automaton createMinimalMoore(const Automaton& other);
+    static Automaton createMinimalMoore(Automaton&& other);
+
+    /**
+     * Create an equivalent minimal automaton with the Moore algorithm and several threads
+     *
+     * The signatures of each round are computed in parallel chunks, then the
+     * classes are assigned by threads owning disjoint ranges of signature
+     * hashes. The result is the same as the one of the sequential version.
+     * With 0 threads, the hardware concurrency is used.
+     */
+    static Automaton createMinimalMoore(const Automaton& other, unsigned threads);
 
     /**
      * Create an equivalent minimal automaton with the Brzozowski algorithm
      */
     static Automaton createMinimalBrzozowski(const Automaton& other);
+    static Automaton createMinimalBrzozowski(Automaton&& other);
+
+    /**
+     * A change of a deterministic automaton, for updateMinimal()
+     */
+    struct Edit {
+      enum class Kind {
+        AddTransition,     // Replace the transition of from with symbol by one towards to
+        RemoveTransition,  // Remove the transition of from with symbol
+        SetFinal,          // Make from final
+        SetNonFinal,       // Make from non-final
+      };
+
+      Kind kind;
+      int from;
+      char symbol;
+      int to;
+    };
+
+    /**
+     * Apply a batch of edits to a minimal automaton and make it minimal again
+     *
+     * The automaton must be minimal, complete and deterministic, as created by
+     * createMinimalMoore(). Only the states that can reach an edited state may
+     * change their language: they are merged with the equivalent unchanged
+     * states, and the others are refined among themselves, the unchanged
+     * states staying apart. The removed transitions lead to a sink state.
+     * If the automaton is not complete and deterministic, it is minimized
+     * from scratch after the edits.
+     * Returns false, without any change, if an edit uses an unknown state or symbol.
+     */
+    bool updateMinimal(const std::vector<Edit>& edits);
+
+    /**
+     * Build the minimal automaton of words added in increasing order
+     *
+     * The words are added to a trie whose branches are minimized as soon as
+     * the next word leaves them, with a register of the states already
+     * minimized (Daciuk et al.), so the whole trie is never held in memory:
+     * only the minimal automaton and the branch of the last word are. The
+     * result is trimmed, it has no sink state.
+     */
+    class WordListBuilder {
+    public:
+      WordListBuilder();
+
+      WordListBuilder(const WordListBuilder&) = delete;
+      WordListBuilder& operator=(const WordListBuilder&) = delete;
+
+      /**
+       * Add a word, not smaller than the previous one
+       *
+       * Returns false if the word is smaller than the previous one or if one
+       * of its characters is not a valid symbol
+       */
+      bool add(std::string_view word);
+
+      /**
+       * Build the automaton of the words added so far, and start a new list
+       */
+      Automaton build();
+
+    private:
+      struct Node {
+        bool isFinal;
+        std::vector<std::pair<char, std::uint32_t>> edges;
+      };
+
+      struct NodeHash {
+        const std::vector<Node>* nodes;
+        std::size_t operator()(std::uint32_t node) const;
+      };
+
+      struct NodeEqual {
+        const std::vector<Node>* nodes;
+        bool operator()(std::uint32_t lhs, std::uint32_t rhs) const;
+      };
+
+      /**
+       * Minimize the branch of the last word below a length
+       */
+      void minimize(std::size_t length);
+
+      std::vector<Node> nodes;
+      std::vector<std::uint32_t> freeNodes;
+      std::unordered_set<std::uint32_t, NodeHash, NodeEqual> registry;
+      // The nodes of the last word, from the root
+      std::vector<std::uint32_t> branch;
+      std::string previous;
+    };
+
+    /**
+     * Create the minimal automaton of a list of sorted words
+     *
+     * Returns nothing if a word is smaller than the previous one or if one of
+     * its characters is not a valid symbol, as WordListBuilder::add().
+     */
+    template<typename Iterator>
+    static std::optional<Automaton> createFromSortedWords(Iterator first, Iterator last) {
+      WordListBuilder builder;
+      for (; first != last; ++first) {
+        if (!builder.add(*first)) {
+          return std::nullopt;
+        }
+      }
+      return builder.build();
+    }
+
+    /**
+     * Create the minimal automaton of a vector of sorted words
+     */
+    static std::optional<Automaton> createFromSortedWords(const std::vector<std::string>& words);
+
+    /**
+     * Create a deterministic automaton accepting the words at an edit
+     * distance of at most maxDistance from a word
+     *
+     * The states are the sets of positions (characters of the word read,
+     * errors made) reached by a prefix, without the positions subsumed by
+     * another one, so the number of states is linear in the length of the
+     * word for a given distance (Schulz and Mihov). The symbols are the ones
+     * of the alphabet and of the word. The automaton is trimmed, it has no
+     * sink state.
+     */
+    static Automaton createLevenshtein(std::string_view word, unsigned maxDistance, std::string_view alphabet);
+
+    /**
+     * Find the words of a dictionary at an edit distance of at most maxDistance from a word
+     *
+     * The Levenshtein automaton of the word is walked in lockstep with the
+     * compiled dictionary. The words are returned in alphabetical order.
+     */
+    static std::vector<std::string> intersectFuzzy(const Automaton& dictionary, std::string_view word, unsigned maxDistance);
 
 
   private:
+    friend class CompiledAutomaton;
+
     /**
        * Go through a graph
        */
     bool depthFirstSearch(const int &initial, std::unordered_set<int> &visited, bool return_) const;
 
+    /**
+     * Same as makeTransition, with the result allocated from a memory resource
+     */
+    std::pmr::set<int> makeTransition(const std::pmr::set<int>& origin, char alpha, std::pmr::memory_resource* resource) const;
+
+    using Transitions = std::pmr::map<char, std::pmr::set<int>>;
+
     struct State {
+      using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+      explicit State(const allocator_type& allocator = {})
+      : state(0), isFinal(false), isInitial(false), transitions(allocator) {}
+      State(const State& other, const allocator_type& allocator)
+      : state(other.state), isFinal(other.isFinal), isInitial(other.isInitial), transitions(other.transitions, allocator) {}
+      State(State&& other, const allocator_type& allocator)
+      : state(other.state), isFinal(other.isFinal), isInitial(other.isInitial), transitions(std::move(other.transitions), allocator) {}
+      State(const State& other) = default;
+      State(State&& other) = default;
+      State& operator=(const State& other) = default;
+      State& operator=(State&& other) = default;
+
       int state;
       bool isFinal;
       bool isInitial;
-      std::map<char, std::set<int>> transitions;
+      Transitions transitions;
     };
 
-    std::map<int, State> states;
-    std::set<char> symbols;
+    /**
+     * Copy the symbols and the states of another automaton, without its
+     * epsilon-transitions, renumbered from first in the order of their numbers
+     *
+     * Returns the new number of each copied state.
+     */
+    std::unordered_map<int, int> appendRenumbered(const Automaton& other, int first);
+
+    /**
+     * Gather the transitions of the initial states, renumbered
+     */
+    Transitions collectInitialTransitions(const Automaton& other, const std::unordered_map<int, int>& numbers) const;
+
+    /**
+     * Explore the product of several automata
+     *
+     * Without a product to fill, stops at the first tuple of final states.
+     * Returns whether such a tuple is reachable.
+     */
+    static bool exploreProduct(const std::vector<const Automaton*>& automata, Automaton* product);
+
+    std::pmr::map<int, State> states;
+    std::pmr::set<char> symbols;
 
     /**
      * Fonctionnement de la structure :
@@ -250,6 +656,640 @@ namespace fa {
      */
   };
 
+  /**
+   * A deterministic automaton compiled into a dense transition table
+   *
+   * The states are renumbered from 0 and state 0 is a dead state: the missing
+   * transitions, the bytes that are not symbols and the states that cannot
+   * reach a final state all lead to it. State indices are stored on 8, 16 or
+   * 32 bits depending on the number of states.
+   */
+  class CompiledAutomaton {
+  public:
+    /**
+     * Compile an automaton, after determinizing it if needed
+     */
+    explicit CompiledAutomaton(const Automaton& automaton);
+
+    /**
+     * Count the number of states, including the dead state
+     */
+    std::size_t countStates() const;
+
+    /**
+     * Count the number of columns of the table (the symbols and one column
+     * for all the other bytes)
+     */
+    std::size_t countColumns() const;
+
+    /**
+     * Get the size in bytes of a state index in the table
+     */
+    std::size_t getStateWidth() const;
+
+    /**
+     * Get the size in bytes of the transition table
+     */
+    std::size_t getTableSize() const;
+
+    /**
+     * Get the initial state
+     */
+    std::uint32_t getInitialState() const;
+
+    /**
+     * Tell if the state is final
+     */
+    bool isStateFinal(std::uint32_t state) const;
+
+    /**
+     * Get the state reached from a state with a byte
+     */
+    std::uint32_t next(std::uint32_t state, char symbol) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton, with several threads
+     *
+     * The word is split in one chunk per thread. Every chunk but the first one
+     * is scanned from all the states at once, merging the states that meet,
+     * then the state reached at the end of each chunk is chained through the
+     * chunks. With 0 threads, the hardware concurrency is used.
+     */
+    bool match(std::string_view word, unsigned threads) const;
+
+    /**
+     * Tell for each word if it is in the language accepted by the automaton
+     *
+     * Several words are scanned in lockstep, so that the loads of their
+     * independent transitions overlap: up to 16 lanes through the table, or
+     * groups of four words with byte shuffles.
+     */
+    std::vector<bool> matchAll(const std::vector<std::string_view>& words, unsigned lanes = 8) const;
+
+    /**
+     * Tell if the words are matched with byte shuffles
+     *
+     * With at most 16 states, the transitions of a byte fit in a 128-bit
+     * shuffle mask, and one SSSE3 pshufb instruction makes a transition.
+     * The instruction set is detected at runtime, the table is used otherwise.
+     */
+    bool isShuffleAccelerated() const;
+
+    /**
+     * Tell if a state loops on nearly all the symbols, all but at most 3 of
+     * them and a fifth of the alphabet, and is left with a byte set search
+     */
+    bool isStateAccelerated(std::uint32_t state) const;
+
+    /**
+     * Get the literal that starts every accepted word
+     */
+    const std::string& getRequiredPrefix() const;
+
+    /**
+     * Get the bytes that can start an accepted word, in increasing order
+     */
+    std::string getFirstBytes() const;
+
+    /**
+     * Find the first position of the text where an accepted word starts
+     *
+     * The candidate positions are found with a search for the required
+     * prefix, or with memchr or a SIMD byte set search on the first bytes.
+     * The runs from overlapping candidates are followed in a single pass and
+     * merged when they reach the same state, so the time stays linear in the
+     * length of the text times the number of states.
+     * Returns std::string_view::npos if no accepted word appears in the text.
+     */
+    std::size_t find(std::string_view text) const;
+
+  private:
+    friend class CompressedAutomaton;
+
+    /**
+     * A set of bytes that can be searched for in a text
+     */
+    struct ByteSet {
+      std::array<std::uint8_t, 256> members;
+      // Bit (b >> 4) & 7 of entry b & 15, for the bytes below and from 128 (truffle masks)
+      std::array<std::uint8_t, 16> lowMasks;
+      std::array<std::uint8_t, 16> highMasks;
+      std::size_t count;
+      char single;
+
+      ByteSet();
+      explicit ByteSet(const std::array<std::uint8_t, 256>& bytes);
+
+      /**
+       * Find the first byte of the set in a text, returns end if there is none
+       */
+      const char* find(const char* begin, const char* end) const;
+    };
+
+    template<typename Index>
+    bool matchTable(const std::vector<Index>& transitions, std::string_view word) const;
+
+    template<typename Index>
+    bool matchTableParallel(const std::vector<Index>& transitions, std::string_view word, unsigned threads) const;
+
+    template<typename Index>
+    void matchTableInterleaved(const std::vector<Index>& transitions, const std::vector<std::string_view>& words, unsigned lanes, std::vector<bool>& result) const;
+
+    std::array<std::uint8_t, 256> columns;
+    std::size_t columnCount;
+    std::uint32_t initial;
+    std::vector<std::uint8_t> finals;
+    std::variant<std::vector<std::uint8_t>, std::vector<std::uint16_t>, std::vector<std::uint32_t>> table;
+    std::vector<std::array<std::uint8_t, 16>> shuffles;
+    std::string requiredPrefix;
+    ByteSet firstBytes;
+    // For each state, 0 or one more than the index of the bytes leaving it in exits
+    std::vector<std::uint32_t> accelerations;
+    std::vector<ByteSet> exits;
+  };
+
+  /**
+   * A deterministic automaton compiled into a row displacement table
+   *
+   * Each state has a default transition, usually towards the dead state, and
+   * only the transitions that differ from it are stored. The rows of all the
+   * states are interleaved in a single pair of next/check arrays: the
+   * transition of a state with a column is stored at its base plus the
+   * column, and the check array tells which state owns the entry.
+   * The states are numbered as in the CompiledAutomaton.
+   */
+  class CompressedAutomaton {
+  public:
+    /**
+     * Compress an automaton, after determinizing it if needed
+     */
+    explicit CompressedAutomaton(const Automaton& automaton);
+
+    /**
+     * Compress a dense table
+     */
+    explicit CompressedAutomaton(const CompiledAutomaton& compiled);
+
+    /**
+     * Count the number of states, including the dead state
+     */
+    std::size_t countStates() const;
+
+    /**
+     * Get the size in bytes of the compressed transition table
+     */
+    std::size_t getTableSize() const;
+
+    /**
+     * Get the initial state
+     */
+    std::uint32_t getInitialState() const;
+
+    /**
+     * Tell if the state is final
+     */
+    bool isStateFinal(std::uint32_t state) const;
+
+    /**
+     * Get the state reached from a state with a byte
+     */
+    std::uint32_t next(std::uint32_t state, char symbol) const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const;
+
+  private:
+    std::array<std::uint8_t, 256> columns;
+    std::uint32_t initial;
+    std::vector<std::uint8_t> finals;
+    std::vector<std::uint32_t> defaults;
+    std::vector<std::uint32_t> bases;
+    std::vector<std::uint32_t> nexts;
+    std::vector<std::uint32_t> checks;
+  };
+
+  /**
+   * A generator of the accepted words of a length, drawn uniformly
+   *
+   * For each remaining length and each state of the compiled automaton, the
+   * number of words leading to a final state is computed once, as doubles
+   * with a separate exponent so that they neither overflow nor underflow,
+   * however far apart the counts of the states are. Each symbol is
+   * then drawn with a probability proportional to the count of its target,
+   * so a word is drawn in a time linear in its length.
+   */
+  class WordSampler {
+  public:
+    /**
+     * Prepare the drawing of the words of a length accepted by an automaton
+     */
+    WordSampler(const Automaton& automaton, std::size_t length);
+
+    /**
+     * Get the length of the words
+     */
+    std::size_t getLength() const;
+
+    /**
+     * Tell if the automaton accepts no word of the length
+     */
+    bool isEmpty() const;
+
+    /**
+     * Draw a word, the sampler must not be empty
+     */
+    std::string sample(std::mt19937_64& generator) const;
+
+    /**
+     * Draw several words with several threads
+     *
+     * Each thread draws a contiguous range of the words with its own
+     * generator, seeded from the seed and its index, so the words only depend
+     * on the seed and the number of threads. With 0 threads, the hardware
+     * concurrency is used. The sampler must not be empty.
+     */
+    std::vector<std::string> sampleBatch(std::size_t count, std::uint64_t seed, unsigned threads = 0) const;
+
+  private:
+    /**
+     * Get the largest exponent of the non-zero counts of the targets of some edges in a layer
+     */
+    int scaleOf(std::size_t layer, std::size_t begin, std::size_t end) const;
+
+    std::size_t length;
+    std::size_t stateCount;
+    std::uint32_t initial;
+    // The transitions of each state towards a live state, from edgeStarts[state]
+    std::vector<std::size_t> edgeStarts;
+    std::vector<char> edgeSymbols;
+    std::vector<std::uint32_t> edgeTargets;
+    // The counts of the words of each remaining length, for each state: mantissas[i] * 2^exponents[i]
+    std::vector<double> mantissas;
+    std::vector<int> exponents;
+  };
+
+  /**
+   * Options of WordEnumerator
+   */
+  struct WordEnumeratorOptions {
+    // The maximum length of the words, prefix included
+    std::size_t maxLength = SIZE_MAX;
+    // The words start with this prefix
+    std::string prefix;
+  };
+
+  /**
+   * A lazy enumeration of the accepted words, by length then in alphabetical order
+   *
+   * The words of each length are enumerated by a depth-first search on the
+   * compiled automaton that only follows the transitions towards the states
+   * having a word of the remaining length, so every branch ends with a word.
+   * The words are built in an internal buffer and returned as views that
+   * are valid until the next word. If the language is finite, the
+   * enumeration stops after its longest word; otherwise it only stops at the
+   * maximum length.
+   */
+  class WordEnumerator {
+  public:
+    /**
+     * A single-pass iterator over the remaining words of an enumerator
+     */
+    class Iterator {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const std::string_view*;
+      using reference = std::string_view;
+
+      explicit Iterator(WordEnumerator* enumerator = nullptr);
+
+      std::string_view operator*() const;
+      Iterator& operator++();
+      bool operator==(const Iterator& other) const;
+      bool operator!=(const Iterator& other) const;
+
+    private:
+      WordEnumerator* enumerator;
+    };
+
+    /**
+     * Prepare the enumeration of the words accepted by an automaton
+     */
+    explicit WordEnumerator(const Automaton& automaton, const WordEnumeratorOptions& options = WordEnumeratorOptions());
+
+    /**
+     * Go to the next word, returns false at the end of the enumeration
+     */
+    bool next();
+
+    /**
+     * Get the current word, valid until the next call to next()
+     */
+    std::string_view getWord() const;
+
+    /**
+     * Iterate over the remaining words, starting with the next one
+     */
+    Iterator begin();
+    Iterator end();
+
+  private:
+    /**
+     * Find the first transition of a state, from an edge, towards a state having a word of a length
+     */
+    std::size_t findEdge(std::uint32_t state, std::size_t from, std::size_t remaining);
+
+    /**
+     * Complete the word with the first transitions from a depth
+     */
+    void descend(std::size_t depth);
+
+    /**
+     * Start the words of the current length
+     */
+    bool startLength();
+
+    /**
+     * Go to the next word of the current length
+     */
+    bool advance();
+
+    std::vector<std::size_t> edgeStarts;
+    std::vector<char> edgeSymbols;
+    std::vector<std::uint32_t> edgeTargets;
+    std::vector<std::uint8_t> finals;
+    // For each length, the states having a word of this length
+    std::vector<std::vector<std::uint8_t>> reachable;
+    std::uint32_t start;
+    std::size_t prefixLength;
+    std::size_t maxLength;
+    std::size_t length;
+    bool started;
+    bool finished;
+    // The states and the chosen transitions along the current word, after the prefix
+    std::vector<std::uint32_t> states;
+    std::vector<std::size_t> choices;
+    std::string word;
+  };
+
+  /**
+   * An immutable automaton shared by reader threads
+   *
+   * A snapshot owns a copy of an automaton, allocated from the global heap
+   * whatever the memory resource of the source, and its compiled table.
+   * It is never modified after its construction, so all its methods can be
+   * called from any number of threads at once without locking. Snapshots
+   * are shared with std::shared_ptr<const Snapshot> and published with a
+   * SnapshotSlot.
+   */
+  class Snapshot {
+  public:
+    /**
+     * Take a snapshot of an automaton
+     */
+    explicit Snapshot(const Automaton& automaton);
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /**
+     * Create a shared snapshot of an automaton
+     */
+    static std::shared_ptr<const Snapshot> create(const Automaton& automaton);
+
+    /**
+     * Get the automaton of the snapshot
+     */
+    const Automaton& getAutomaton() const;
+
+    /**
+     * Get the compiled table of the snapshot
+     */
+    const CompiledAutomaton& getCompiled() const;
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    bool match(std::string_view word) const;
+
+    /**
+     * Find the first position of the text where an accepted word starts
+     */
+    std::size_t find(std::string_view text) const;
+
+  private:
+    Automaton automaton;
+    CompiledAutomaton compiled;
+  };
+
+  /**
+   * A slot where a writer publishes the current snapshot for the readers
+   *
+   * load() and store() are atomic: a reader gets either the previous or the
+   * next snapshot, and keeps it alive as long as it holds the pointer, while
+   * the writer builds and stores the next version. The standard library may
+   * implement the atomic operations on a std::shared_ptr with a short
+   * internal lock, but the queries on a loaded snapshot never lock.
+   */
+  class SnapshotSlot {
+  public:
+    /**
+     * Build a slot holding a snapshot, or nothing
+     */
+    explicit SnapshotSlot(std::shared_ptr<const Snapshot> snapshot = nullptr);
+
+    SnapshotSlot(const SnapshotSlot&) = delete;
+    SnapshotSlot& operator=(const SnapshotSlot&) = delete;
+
+    /**
+     * Get the current snapshot
+     */
+    std::shared_ptr<const Snapshot> load() const;
+
+    /**
+     * Replace the current snapshot
+     */
+    void store(std::shared_ptr<const Snapshot> snapshot);
+
+  private:
+    std::shared_ptr<const Snapshot> current;
+  };
+
+  /**
+   * A transition of a StaticAutomaton
+   */
+  struct StaticTransition {
+    int from;
+    char symbol;
+    int to;
+  };
+
+  /**
+   * An automaton described at compile time
+   *
+   * The states are numbered from 0 to StateCount - 1 and the transitions are
+   * stored in a dense table, so that a constexpr automaton has no
+   * construction cost and its match loop can be inlined. The transitions
+   * whose states are out of range or whose symbol is not a printable
+   * character are ignored. Every query is constexpr and can be checked with
+   * static_assert; match() only follows the first transition of each state
+   * and symbol, so it needs a deterministic automaton.
+   */
+  template<std::size_t StateCount>
+  class StaticAutomaton {
+  public:
+    /**
+     * Build an automaton from its transitions, its initial state and its final states
+     */
+    template<std::size_t TransitionCount, std::size_t FinalCount>
+    constexpr StaticAutomaton(const StaticTransition (&transitions)[TransitionCount], int initial, const int (&finals)[FinalCount])
+    : table(), finalStates(), symbols(), initialState(initial), transitionCount(0), deterministic(true)
+    {
+      for (auto& row : table) {
+        for (auto& target : row) {
+          target = -1;
+        }
+      }
+      for (const StaticTransition& transition : transitions) {
+        if (!isValidState(transition.from) || !isValidState(transition.to) || transition.symbol <= ' ' || transition.symbol > '~') {
+          continue;
+        }
+        int& target = table[transition.from][static_cast<unsigned char>(transition.symbol)];
+        if (target == transition.to) {
+          continue;
+        }
+        if (target != -1) {
+          deterministic = false;
+          continue;
+        }
+        target = transition.to;
+        symbols[static_cast<unsigned char>(transition.symbol)] = true;
+        ++transitionCount;
+      }
+      for (const int state : finals) {
+        if (isValidState(state)) {
+          finalStates[state] = true;
+        }
+      }
+      if (!isValidState(initialState)) {
+        initialState = -1;
+      }
+    }
+
+    /**
+     * Count the number of states
+     */
+    constexpr std::size_t countStates() const {
+      return StateCount;
+    }
+
+    /**
+     * Count the number of transitions kept in the table
+     */
+    constexpr std::size_t countTransitions() const {
+      return transitionCount;
+    }
+
+    /**
+     * Tell if the state is final
+     */
+    constexpr bool isStateFinal(int state) const {
+      return isValidState(state) && finalStates[state];
+    }
+
+    /**
+     * Get the state reached from a state with a byte, or -1 if there is none
+     */
+    constexpr int next(int state, char symbol) const {
+      return isValidState(state) ? table[state][static_cast<unsigned char>(symbol)] : -1;
+    }
+
+    /**
+     * Tell if the automaton has at most one transition for each state and symbol
+     */
+    constexpr bool isDeterministic() const {
+      return deterministic && initialState != -1;
+    }
+
+    /**
+     * Tell if every state has a transition for every symbol
+     */
+    constexpr bool isComplete() const {
+      for (std::size_t state = 0; state < StateCount; ++state) {
+        for (std::size_t symbol = 0; symbol < 256; ++symbol) {
+          if (symbols[symbol] && table[state][symbol] == -1) {
+            return false;
+          }
+        }
+      }
+      return initialState != -1;
+    }
+
+    /**
+     * Tell if the word is in the language accepted by the automaton
+     */
+    constexpr bool match(std::string_view word) const {
+      int state = initialState;
+      for (const char c : word) {
+        if (state == -1) {
+          return false;
+        }
+        state = table[state][static_cast<unsigned char>(c)];
+      }
+      return state != -1 && finalStates[state];
+    }
+
+    /**
+     * Build the equivalent run-time automaton, keeping the first transition
+     * of each state and symbol
+     */
+    Automaton toAutomaton() const {
+      Automaton automaton;
+      for (std::size_t symbol = 0; symbol < 256; ++symbol) {
+        if (symbols[symbol]) {
+          automaton.addSymbol(static_cast<char>(symbol));
+        }
+      }
+      for (std::size_t state = 0; state < StateCount; ++state) {
+        automaton.addState(static_cast<int>(state));
+        if (finalStates[state]) {
+          automaton.setStateFinal(static_cast<int>(state));
+        }
+      }
+      for (std::size_t state = 0; state < StateCount; ++state) {
+        for (std::size_t symbol = 0; symbol < 256; ++symbol) {
+          if (table[state][symbol] != -1) {
+            automaton.addTransition(static_cast<int>(state), static_cast<char>(symbol), table[state][symbol]);
+          }
+        }
+      }
+      if (initialState != -1) {
+        automaton.setStateInitial(initialState);
+      }
+      return automaton;
+    }
+
+  private:
+    static constexpr bool isValidState(int state) {
+      return state >= 0 && static_cast<std::size_t>(state) < StateCount;
+    }
+
+    std::array<std::array<int, 256>, StateCount> table;
+    std::array<bool, StateCount> finalStates;
+    std::array<bool, 256> symbols;
+    int initialState;
+    std::size_t transitionCount;
+    bool deterministic;
+  };
+
 }
 
 #endif // AUTOMATON_H
@@ -2,7 +2,15 @@
 #include "gtest/gtest.h"
 
 #include "Automaton.h"
+#include "testfa_generated.h"
+#include <algorithm>
 #include <climits>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 // Example test
 TEST(AutomatonExampleTest, Default) {
@@ -28,6 +36,85 @@ TEST(AutomatonIsValidTest, valid) {
   EXPECT_TRUE(fa.isValid());
 }
 
+// Tests for getMemoryResource()
+namespace {
+  class CountingResource : public std::pmr::memory_resource {
+  public:
+    std::size_t allocations = 0;
+    std::size_t live = 0;
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+      ++allocations;
+      ++live;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+      --live;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+}
+TEST(AutomatonMemoryResourceTest, defaultResource) {
+  fa::Automaton fa;
+  EXPECT_EQ(fa.getMemoryResource(), std::pmr::get_default_resource());
+}
+TEST(AutomatonMemoryResourceTest, statesAndTransitions) {
+  CountingResource resource;
+  {
+    fa::Automaton fa(&resource);
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.addTransition(0, 'a', 1);
+    EXPECT_EQ(fa.getMemoryResource(), &resource);
+    EXPECT_GE(resource.allocations, 5u);
+  }
+  EXPECT_EQ(resource.live, 0u);
+}
+TEST(AutomatonMemoryResourceTest, propagatedToCreatedAutomata) {
+  CountingResource resource;
+  fa::Automaton fa(&resource);
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateInitial(1);
+  fa.setStateFinal(1);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'a', 1);
+
+  const fa::Automaton copy = fa;
+  const fa::Automaton deterministic = fa::Automaton::createDeterministic(fa);
+  const fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+  EXPECT_EQ(copy.getMemoryResource(), &resource);
+  EXPECT_EQ(deterministic.getMemoryResource(), &resource);
+  EXPECT_EQ(minimal.getMemoryResource(), &resource);
+  EXPECT_TRUE(minimal.match("aa") && minimal.match(""));
+}
+TEST(AutomatonMemoryResourceTest, monotonicArena) {
+  std::pmr::monotonic_buffer_resource arena;
+  fa::Automaton fa(&arena);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for (int i = 0; i < 100; ++i) {
+    fa.addState(i);
+  }
+  for (int i = 0; i < 99; ++i) {
+    fa.addTransition(i, 'a', i + 1);
+    fa.addTransition(i, 'b', 0);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(99);
+  fa.complete();
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_TRUE(fa.match(std::string(99, 'a')));
+  EXPECT_FALSE(fa.match(std::string(98, 'a')));
+}
+
 // Tests for addSymbol()
 TEST(AutomatonAddSymbolTest, epsilon) {
   fa::Automaton fa;
@@ -1229,6 +1316,45 @@ TEST(AutomatonCreateMirrorTest, mirrorTransition) {
   EXPECT_TRUE(mirror.isLanguageEmpty());
 }
 
+// Tests for createMirror(Automaton&&) and mirrorInPlace()
+TEST(AutomatonMirrorInPlaceTest, reversedLanguage) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'b', 2);
+  fa.addTransition(1, 'b', 1);
+  EXPECT_TRUE(fa.match("abb"));
+  fa.mirrorInPlace();
+  EXPECT_EQ(fa.countTransitions(), 3u);
+  EXPECT_TRUE(fa.isStateInitial(2) && fa.isStateFinal(0));
+  EXPECT_TRUE(fa.hasTransition(1, 'a', 0));
+  EXPECT_TRUE(fa.hasTransition(2, 'b', 1));
+  EXPECT_TRUE(fa.match("bba"));
+  EXPECT_FALSE(fa.match("abb"));
+}
+TEST(AutomatonMirrorInPlaceTest, sameAsCreateMirror) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'b', 0);
+  fa.addTransition(1, 'a', 0);
+  const fa::Automaton mirror = fa::Automaton::createMirror(fa);
+  const fa::Automaton moved = fa::Automaton::createMirror(fa::Automaton(fa));
+  EXPECT_TRUE(mirror.isIncludedIn(moved) && moved.isIncludedIn(mirror));
+  EXPECT_EQ(moved.countTransitions(), fa.countTransitions());
+}
+
 // Tests for createComplete()
 TEST(AutomatonCreateCompleteTest, alreadyComplete) {
   fa::Automaton fa;
@@ -1266,6 +1392,31 @@ TEST(AutomatonCreateCompleteTest, maxInt) {
   EXPECT_FALSE(fa.isComplete());
   EXPECT_TRUE(complete.isComplete());
 }
+TEST(AutomatonCreateCompleteTest, inPlace) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.complete();
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_EQ(fa.countStates(), 3u);
+  EXPECT_TRUE(fa.match("a"));
+  EXPECT_FALSE(fa.match("ab"));
+}
+TEST(AutomatonCreateCompleteTest, movedAutomaton) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 0);
+  const fa::Automaton complete = fa::Automaton::createComplete(std::move(fa));
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(complete.countSymbols(), 2u);
+}
 // TEST(AutomatonCreateCompleteTest, alreadySinkState) {
 //   fa::Automaton fa;
 //   fa.addState(0);
@@ -1381,6 +1532,38 @@ TEST(AutomatonCreateComplementTest, exampleAutomaton) {
   EXPECT_FALSE(complement.match("ababaaa"));
 }
 
+TEST(AutomatonCreateComplementTest, inPlace) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateInitial(1);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'b', 1);
+  fa.complementInPlace();
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_FALSE(fa.match("abb"));
+  EXPECT_FALSE(fa.match(""));
+  EXPECT_TRUE(fa.match("ba"));
+}
+TEST(AutomatonCreateComplementTest, movedAutomaton) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addTransition(0, 'a', 1);
+  const fa::Automaton complement = fa::Automaton::createComplement(std::move(fa));
+  EXPECT_TRUE(complement.match(""));
+  EXPECT_FALSE(complement.match("a"));
+  EXPECT_TRUE(complement.match("aa"));
+}
+
 // Tests for createIntersection()
 TEST(AutomatonCreateIntersectionTest, noInitialStates) {
   fa::Automaton fa1;
@@ -1714,6 +1897,104 @@ TEST(AutomatonCreateDeterministicTest, DS2024) {
   EXPECT_TRUE(fa.isIncludedIn(deterministic) && deterministic.isIncludedIn(fa));
 }
 
+// Tests for createDeterministic() with threads
+namespace {
+  fa::Automaton createRandomAutomaton(int states, const std::string& symbols, int transitions, unsigned seed) {
+    fa::Automaton fa;
+    for (const char symbol : symbols) {
+      fa.addSymbol(symbol);
+    }
+    for (int i = 0; i < states; ++i) {
+      fa.addState(i);
+    }
+    // Small linear congruential generator, so that the automaton is the same on every platform
+    auto random = [&seed](int bound) {
+      seed = seed * 1103515245u + 12345u;
+      return static_cast<int>((seed >> 16) % static_cast<unsigned>(bound));
+    };
+    for (int i = 0; i < transitions; ++i) {
+      fa.addTransition(random(states), symbols[random(static_cast<int>(symbols.size()))], random(states));
+    }
+    fa.setStateInitial(0);
+    fa.setStateInitial(random(states));
+    fa.setStateFinal(random(states));
+    fa.setStateFinal(random(states));
+    return fa;
+  }
+
+  void expectSameAutomaton(const fa::Automaton& lhs, const fa::Automaton& rhs, const std::string& symbols) {
+    ASSERT_EQ(lhs.countStates(), rhs.countStates());
+    ASSERT_EQ(lhs.countTransitions(), rhs.countTransitions());
+    const int count = static_cast<int>(lhs.countStates());
+    for (int from = 0; from < count; ++from) {
+      EXPECT_EQ(lhs.isStateInitial(from), rhs.isStateInitial(from));
+      EXPECT_EQ(lhs.isStateFinal(from), rhs.isStateFinal(from));
+      for (const char symbol : symbols) {
+        for (int to = 0; to < count; ++to) {
+          EXPECT_EQ(lhs.hasTransition(from, symbol, to), rhs.hasTransition(from, symbol, to));
+        }
+      }
+    }
+  }
+}
+TEST(AutomatonCreateDeterministicThreadsTest, determinisationNeeded) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'b', 1);
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa, 4);
+  EXPECT_TRUE(deterministic.isDeterministic());
+  EXPECT_TRUE(deterministic.match("aaabbbb") && deterministic.match("a"));
+  expectSameAutomaton(deterministic, fa::Automaton::createDeterministic(fa), "ab");
+}
+TEST(AutomatonCreateDeterministicThreadsTest, emptyLanguage) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addTransition(0, 'a', 1);
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa, 4);
+  EXPECT_TRUE(deterministic.isDeterministic());
+  EXPECT_TRUE(deterministic.isLanguageEmpty());
+}
+TEST(AutomatonCreateDeterministicThreadsTest, sameResultForAnyThreadCount) {
+  const fa::Automaton fa = createRandomAutomaton(12, "abc", 40, 7);
+  const fa::Automaton sequential = fa::Automaton::createDeterministic(fa);
+  for (unsigned threads : {2u, 3u, 8u}) {
+    const fa::Automaton parallel = fa::Automaton::createDeterministic(fa, threads);
+    EXPECT_TRUE(parallel.isDeterministic());
+    expectSameAutomaton(parallel, sequential, "abc");
+  }
+}
+TEST(AutomatonCreateDeterministicTest, sameResultFromRvalue) {
+  // Already deterministic, with sparse numbers and a non-accessible state
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(4);
+  fa.addState(9);
+  fa.addState(2);
+  fa.setStateInitial(9);
+  fa.setStateFinal(4);
+  fa.addTransition(9, 'a', 4);
+  fa.addTransition(4, 'b', 9);
+  fa.addTransition(2, 'a', 9);
+  ASSERT_TRUE(fa.isDeterministic());
+
+  const fa::Automaton copied = fa::Automaton::createDeterministic(fa);
+  const fa::Automaton moved = fa::Automaton::createDeterministic(fa::Automaton(fa));
+  EXPECT_EQ(copied.countStates(), 2u);
+  EXPECT_TRUE(copied.isStateInitial(0));
+  expectSameAutomaton(moved, copied, "ab");
+}
+
 // Tests for isIncludedIn()
 TEST(AutomatonIsIncludedInTest, emptyLanguage) { // Could fail
   fa::Automaton fa;
@@ -1889,6 +2170,91 @@ TEST(AutomatonCreateMinimalMooreTest, DS2024) {
   EXPECT_TRUE(minimal.isComplete());
 }
 
+TEST(AutomatonCreateMinimalMooreTest, initialNotRepresentative) {
+  // States 1 and 3 are equivalent, the initial state 3 is not the first of its class
+  fa::Automaton fa;
+  fa.addState(1);
+  fa.addState(3);
+  fa.setStateInitial(3);
+  fa.setStateFinal(1);
+  fa.setStateFinal(3);
+  fa.addSymbol('a');
+  fa.addTransition(1, 'a', 1);
+  fa.addTransition(3, 'a', 1);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+
+  EXPECT_EQ(minimal.countStates(), 1u);
+  EXPECT_TRUE(minimal.match("") && minimal.match("aaa"));
+  EXPECT_TRUE(minimal.isDeterministic());
+}
+
+TEST(AutomatonCreateMinimalMooreTest, initialReachingEquivalentState) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(1);
+  fa.setStateFinal(2);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(1, 'a', 0);
+  fa.addTransition(1, 'b', 2);
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 2);
+  fa.addTransition(2, 'a', 2);
+  fa.addTransition(2, 'b', 2);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+
+  EXPECT_EQ(minimal.countStates(), 2u);
+  EXPECT_TRUE(minimal.match("b"));
+  EXPECT_TRUE(minimal.match("aab"));
+  EXPECT_FALSE(minimal.match("aa"));
+}
+
+// Tests for createMinimalMoore() with threads
+TEST(AutomatonCreateMinimalMooreThreadsTest, DS2024) {
+  fa::Automaton fa;
+  for (int i = 1; i <= 7; ++i) {
+    fa.addState(i);
+  }
+  fa.setStateInitial(1);
+  fa.setStateFinal(5);
+  fa.setStateFinal(7);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(1, 'a', 4);
+  fa.addTransition(1, 'b', 2);
+  fa.addTransition(2, 'a', 4);
+  fa.addTransition(2, 'b', 5);
+  fa.addTransition(3, 'a', 4);
+  fa.addTransition(3, 'b', 7);
+  fa.addTransition(4, 'a', 5);
+  fa.addTransition(4, 'b', 6);
+  fa.addTransition(5, 'a', 3);
+  fa.addTransition(6, 'a', 4);
+  fa.addTransition(6, 'b', 3);
+  fa.addTransition(7, 'a', 3);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa, 4);
+
+  EXPECT_EQ(minimal.countStates(), 5u);
+  EXPECT_TRUE(minimal.isDeterministic());
+  EXPECT_TRUE(minimal.isComplete());
+  EXPECT_TRUE(minimal.isIncludedIn(fa) && fa.isIncludedIn(minimal));
+  expectSameAutomaton(minimal, fa::Automaton::createMinimalMoore(fa), "ab");
+}
+TEST(AutomatonCreateMinimalMooreThreadsTest, sameResultForAnyThreadCount) {
+  const fa::Automaton fa = createRandomAutomaton(10, "ab", 25, 3);
+  const fa::Automaton sequential = fa::Automaton::createMinimalMoore(fa);
+  for (unsigned threads : {1u, 2u, 5u}) {
+    const fa::Automaton parallel = fa::Automaton::createMinimalMoore(fa, threads);
+    expectSameAutomaton(parallel, sequential, "ab");
+    EXPECT_TRUE(parallel.isIncludedIn(fa) && fa.isIncludedIn(parallel));
+  }
+}
+
 // Tests for createMinimalBrzozowski
 TEST(AutomatonCreateMinimalBrzozowskiTest, emptyAutomaton) {
   fa::Automaton fa;
@@ -1980,6 +2346,1726 @@ TEST(AutomatonCreateMinimalBrzozowskiTest, DS2024) {
 }
 
 
+// Tests for CompiledAutomaton
+namespace {
+  fa::Automaton createChain(int length) {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    for (int i = 0; i <= length; ++i) {
+      fa.addState(i);
+    }
+    for (int i = 0; i < length; ++i) {
+      fa.addTransition(i, 'a', i + 1);
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(length);
+    return fa;
+  }
+}
+TEST(CompiledAutomatonTest, sameLanguage) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 0);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'b', 2);
+  EXPECT_FALSE(fa.isDeterministic());
+
+  const fa::CompiledAutomaton compiled(fa);
+  for (const char* word : {"", "a", "ab", "bab", "abb", "aabab", "abab", "ba", "abc", "a b"}) {
+    EXPECT_EQ(compiled.match(word), fa.match(word)) << word;
+  }
+}
+TEST(CompiledAutomatonTest, deadState) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'b', 2);
+  fa.addTransition(2, 'a', 2);
+
+  const fa::CompiledAutomaton compiled(fa);
+  // State 2 cannot reach a final state and is merged with the dead state
+  EXPECT_EQ(compiled.countStates(), 3u);
+  EXPECT_EQ(compiled.countColumns(), 3u);
+  EXPECT_EQ(compiled.next(compiled.getInitialState(), 'b'), 0u);
+  EXPECT_EQ(compiled.next(compiled.getInitialState(), 'z'), 0u);
+  EXPECT_TRUE(compiled.isStateFinal(compiled.next(compiled.getInitialState(), 'a')));
+  EXPECT_TRUE(compiled.match("a"));
+  EXPECT_FALSE(compiled.match("ba"));
+}
+TEST(CompiledAutomatonTest, emptyLanguage) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addSymbol('a');
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_EQ(compiled.countStates(), 1u);
+  EXPECT_EQ(compiled.getInitialState(), 0u);
+  EXPECT_FALSE(compiled.match(""));
+  EXPECT_FALSE(compiled.match("a"));
+}
+TEST(CompiledAutomatonTest, stateWidth) {
+  const fa::CompiledAutomaton small(createChain(10));
+  EXPECT_EQ(small.getStateWidth(), 1u);
+  EXPECT_EQ(small.getTableSize(), small.countStates() * small.countColumns());
+  EXPECT_TRUE(small.match(std::string(10, 'a')));
+
+  const fa::CompiledAutomaton medium(createChain(300));
+  EXPECT_EQ(medium.getStateWidth(), 2u);
+  EXPECT_EQ(medium.getTableSize(), medium.countStates() * medium.countColumns() * 2);
+  EXPECT_TRUE(medium.match(std::string(300, 'a')));
+  EXPECT_FALSE(medium.match(std::string(299, 'a')));
+
+  const fa::CompiledAutomaton large(createChain(70000));
+  EXPECT_EQ(large.getStateWidth(), 4u);
+  EXPECT_TRUE(large.match(std::string(70000, 'a')));
+  EXPECT_FALSE(large.match(std::string(70001, 'a')));
+}
+TEST(CompiledAutomatonTest, parallelMatch) {
+  // Words over {a, b} with an even number of a and ending with b
+  fa::Automaton fa;
+  for (int i = 0; i < 4; ++i) {
+    fa.addState(i);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'b', 2);
+  fa.addTransition(1, 'a', 0);
+  fa.addTransition(1, 'b', 3);
+  fa.addTransition(2, 'a', 1);
+  fa.addTransition(2, 'b', 2);
+  fa.addTransition(3, 'a', 0);
+  fa.addTransition(3, 'b', 3);
+  const fa::CompiledAutomaton compiled(fa);
+
+  std::string word;
+  unsigned seed = 42;
+  for (int i = 0; i < 200000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    word.push_back((seed >> 16) % 3 == 0 ? 'a' : 'b');
+  }
+  for (const std::string& candidate : {word, word + "a", word + "ab", word + "aab", word + "c" + word}) {
+    const bool expected = compiled.match(candidate);
+    for (unsigned threads : {1u, 2u, 3u, 7u}) {
+      EXPECT_EQ(compiled.match(candidate, threads), expected);
+    }
+  }
+}
+TEST(CompiledAutomatonTest, parallelMatchShortWord) {
+  const fa::CompiledAutomaton compiled(createChain(3));
+  EXPECT_TRUE(compiled.match("aaa", 4));
+  EXPECT_FALSE(compiled.match("aa", 4));
+  EXPECT_FALSE(compiled.match(std::string(100000, 'a'), 4));
+}
+TEST(CompiledAutomatonTest, shuffleMatch) {
+  const fa::Automaton fa = createRandomAutomaton(5, "abc", 20, 11);
+  const fa::CompiledAutomaton compiled(fa);
+  ASSERT_LE(compiled.countStates(), 16u);
+  std::string word;
+  unsigned seed = 5;
+  for (int i = 0; i < 300; ++i) {
+    EXPECT_EQ(compiled.match(word), fa.match(word)) << word;
+    seed = seed * 1103515245u + 12345u;
+    word.push_back("abcd"[(seed >> 16) % 4]);
+    if ((seed >> 8) % 7 == 0) {
+      word.clear();
+    }
+  }
+}
+TEST(CompiledAutomatonTest, shuffleLimit) {
+  const fa::CompiledAutomaton small(createChain(14));
+  EXPECT_EQ(small.countStates(), 16u);
+  const fa::CompiledAutomaton large(createChain(15));
+  EXPECT_FALSE(large.isShuffleAccelerated());
+  EXPECT_TRUE(small.match(std::string(14, 'a')));
+  EXPECT_FALSE(small.match(std::string(15, 'a')));
+  EXPECT_TRUE(large.match(std::string(15, 'a')));
+}
+TEST(CompiledAutomatonTest, matchAll) {
+  const fa::Automaton fa = createRandomAutomaton(6, "ab", 20, 19);
+  const std::vector<std::string> words = { "", "a", "ab", "ba", "abba", "babab", "aaaaaaaab", "b", "bbbbbbbbbbbbb", "abc", "abababab" };
+  for (const fa::CompiledAutomaton& compiled : { fa::CompiledAutomaton(fa), fa::CompiledAutomaton(createChain(20)) }) {
+    std::vector<std::string_view> views(words.begin(), words.end());
+    const std::vector<bool> result = compiled.matchAll(views);
+    ASSERT_EQ(result.size(), words.size());
+    for (std::size_t i = 0; i < words.size(); ++i) {
+      EXPECT_EQ(result[i], compiled.match(words[i])) << words[i];
+    }
+  }
+}
+TEST(CompiledAutomatonTest, matchAllLanes) {
+  // Words over {a, b, c} whose length is a multiple of 20
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addSymbol('c');
+  for (int i = 0; i < 20; ++i) {
+    fa.addState(i);
+  }
+  for (int i = 0; i < 20; ++i) {
+    fa.addTransition(i, 'a', (i + 1) % 20);
+    fa.addTransition(i, 'b', (i + 1) % 20);
+    fa.addTransition(i, 'c', (i + 1) % 20);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_FALSE(compiled.isShuffleAccelerated());
+
+  std::vector<std::string> words;
+  for (std::size_t length = 0; length < 70; ++length) {
+    words.push_back(std::string(length, "abc"[length % 3]));
+  }
+  words.push_back(std::string(20, 'a') + "d" + std::string(19, 'a'));
+  std::vector<std::string_view> views(words.begin(), words.end());
+  for (unsigned lanes : {0u, 1u, 4u, 7u, 16u, 64u}) {
+    const std::vector<bool> result = compiled.matchAll(views, lanes);
+    ASSERT_EQ(result.size(), words.size());
+    for (std::size_t i = 0; i < words.size(); ++i) {
+      EXPECT_EQ(result[i], fa.match(words[i])) << words[i] << " with " << lanes << " lanes";
+    }
+  }
+}
+TEST(CompiledAutomatonTest, requiredPrefix) {
+  // abc(d|e)
+  fa::Automaton fa;
+  for (int i = 0; i < 5; ++i) {
+    fa.addState(i);
+  }
+  for (char symbol : std::string("abcde")) {
+    fa.addSymbol(symbol);
+  }
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'b', 2);
+  fa.addTransition(2, 'c', 3);
+  fa.addTransition(3, 'd', 4);
+  fa.addTransition(3, 'e', 4);
+  fa.setStateInitial(0);
+  fa.setStateFinal(4);
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_EQ(compiled.getRequiredPrefix(), "abc");
+  EXPECT_EQ(compiled.getFirstBytes(), "a");
+  EXPECT_EQ(compiled.find("abcabxabcfabce"), 10u);
+  EXPECT_EQ(compiled.find("abcd"), 0u);
+  EXPECT_EQ(compiled.find("abcabc"), std::string_view::npos);
+  EXPECT_EQ(compiled.find(""), std::string_view::npos);
+}
+TEST(CompiledAutomatonTest, findTrivial) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  const fa::CompiledAutomaton empty(fa);
+  EXPECT_EQ(empty.getFirstBytes(), "");
+  EXPECT_EQ(empty.find("aaaa"), std::string_view::npos);
+
+  fa.setStateFinal(0);
+  const fa::CompiledAutomaton epsilon(fa);
+  EXPECT_EQ(epsilon.getRequiredPrefix(), "");
+  EXPECT_EQ(epsilon.find(""), 0u);
+  EXPECT_EQ(epsilon.find("bbb"), 0u);
+}
+TEST(CompiledAutomatonTest, findFirstBytes) {
+  std::size_t tested = 0;
+  for (unsigned seed = 0; seed < 60; ++seed) {
+    const fa::CompiledAutomaton compiled(createRandomAutomaton(5, "abcd", 10, seed));
+    if (compiled.match("")) {
+      continue;
+    }
+    ++tested;
+
+    // Long runs of other bytes, including some above 127, between the symbols
+    std::string text;
+    unsigned state = seed;
+    for (int i = 0; i < 400; ++i) {
+      state = state * 1103515245u + 12345u;
+      const unsigned draw = (state >> 16) % 64;
+      text.push_back(draw < 4 ? "abcd"[draw] : static_cast<char>(draw < 32 ? 'e' + draw : 128 + draw));
+    }
+
+    std::size_t expected = std::string_view::npos;
+    for (std::size_t start = 0; start < text.size() && expected == std::string_view::npos; ++start) {
+      for (std::size_t length = 1; start + length <= text.size(); ++length) {
+        if (compiled.match(std::string_view(text).substr(start, length))) {
+          expected = start;
+          break;
+        }
+      }
+    }
+    EXPECT_EQ(compiled.find(text), expected) << seed;
+  }
+  EXPECT_GE(tested, 10u);
+}
+TEST(CompiledAutomatonTest, findLongWithoutMatch) {
+  // a[ac]*b: every a of the text starts a candidate that only fails at its end
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addSymbol('c');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'a', 1);
+  fa.addTransition(1, 'c', 1);
+  fa.addTransition(1, 'b', 2);
+  const fa::CompiledAutomaton compiled(fa);
+
+  std::string text;
+  for (int i = 0; i < 200000; ++i) {
+    text += i % 3 == 0 ? "ac" : "a";
+  }
+  EXPECT_EQ(compiled.find(text), std::string_view::npos);
+  EXPECT_EQ(compiled.find("x" + text + "b"), 1u);
+  EXPECT_EQ(compiled.find("cc" + text + "xab"), text.size() + 3);
+}
+TEST(CompiledAutomatonTest, findEarliestStart) {
+  // The word starting first is found, even when a later one ends before it
+  const fa::CompiledAutomaton compiled(*fa::Automaton::createFromSortedWords({ "abcd", "bc" }));
+  EXPECT_EQ(compiled.find("xabcd"), 1u);
+  EXPECT_EQ(compiled.find("xabcx"), 2u);
+  EXPECT_EQ(compiled.find("xabxbc"), 4u);
+}
+TEST(CompiledAutomatonTest, acceleratedStates) {
+  // {[a-z]*}
+  fa::Automaton fa;
+  fa.addSymbol('{');
+  fa.addSymbol('}');
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    fa.addSymbol(symbol);
+  }
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0, '{', 1);
+  fa.addTransition(1, '}', 2);
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    fa.addTransition(1, symbol, 1);
+  }
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_FALSE(compiled.isStateAccelerated(compiled.getInitialState()));
+  EXPECT_TRUE(compiled.isStateAccelerated(compiled.next(compiled.getInitialState(), '{')));
+
+  for (std::size_t length = 0; length < 50; ++length) {
+    std::string inner;
+    for (std::size_t i = 0; i < length; ++i) {
+      inner.push_back(static_cast<char>('a' + i % 26));
+    }
+    EXPECT_TRUE(compiled.match("{" + inner + "}")) << length;
+    EXPECT_FALSE(compiled.match("{" + inner)) << length;
+    EXPECT_FALSE(compiled.match("{" + inner + "}}")) << length;
+    EXPECT_FALSE(compiled.match("{" + inner + "{}")) << length;
+    EXPECT_FALSE(compiled.match("{" + inner + "\xe9}")) << length;
+    EXPECT_EQ(compiled.find("}{" + inner + "{" + inner + "}"), length + 2) << length;
+  }
+}
+TEST(CompiledAutomatonTest, acceleratedLargeTable) {
+  // abcdefghijklmnopqrst{[a-z]*}: too many states for the shuffles
+  const std::string prefix = "abcdefghijklmnopqrst";
+  fa::Automaton fa;
+  fa.addSymbol('{');
+  fa.addSymbol('}');
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    fa.addSymbol(symbol);
+  }
+  const int loop = static_cast<int>(prefix.size()) + 1;
+  for (int i = 0; i <= loop + 1; ++i) {
+    fa.addState(i);
+  }
+  for (int i = 0; i < static_cast<int>(prefix.size()); ++i) {
+    fa.addTransition(i, prefix[i], i + 1);
+  }
+  fa.addTransition(loop - 1, '{', loop);
+  fa.addTransition(loop, '}', loop + 1);
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    fa.addTransition(loop, symbol, loop);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(loop + 1);
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_FALSE(compiled.isShuffleAccelerated());
+  std::uint32_t state = compiled.getInitialState();
+  for (const char symbol : prefix + "{") {
+    EXPECT_FALSE(compiled.isStateAccelerated(state));
+    state = compiled.next(state, symbol);
+  }
+  EXPECT_TRUE(compiled.isStateAccelerated(state));
+
+  for (std::size_t length = 0; length < 100; length += 7) {
+    std::string inner;
+    for (std::size_t i = 0; i < length; ++i) {
+      inner.push_back(static_cast<char>('a' + i % 26));
+    }
+    EXPECT_TRUE(compiled.match(prefix + "{" + inner + "}")) << length;
+    EXPECT_FALSE(compiled.match(prefix + "{" + inner)) << length;
+    EXPECT_FALSE(compiled.match(prefix + "{" + inner + "}}")) << length;
+    EXPECT_FALSE(compiled.match(prefix + "{" + inner + "\xe9}")) << length;
+  }
+}
+TEST(CompiledAutomatonTest, notAcceleratedOnFewLoops) {
+  // a*b: the loop on a leaves on b, half of the alphabet
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 1);
+  const fa::CompiledAutomaton compiled(fa);
+  EXPECT_FALSE(compiled.isStateAccelerated(compiled.getInitialState()));
+  EXPECT_TRUE(compiled.match("aaab"));
+}
+TEST(CompiledAutomatonTest, acceleratedSameLanguage) {
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(4, "ab", 10, seed);
+    const fa::CompiledAutomaton compiled(fa);
+    unsigned state = seed;
+    for (int i = 0; i < 50; ++i) {
+      std::string word;
+      state = state * 1103515245u + 12345u;
+      const std::size_t length = (state >> 16) % 40;
+      for (std::size_t j = 0; j < length; ++j) {
+        state = state * 1103515245u + 12345u;
+        word.push_back("ab"[(state >> 16) % 2]);
+      }
+      EXPECT_EQ(compiled.match(word), fa.match(word)) << seed << " " << word;
+    }
+  }
+}
+
+// Tests for CompressedAutomaton
+TEST(CompressedAutomatonTest, sameTransitions) {
+  fa::Automaton fa;
+  for (int i = 0; i < 5; ++i) {
+    fa.addState(i);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(3);
+  fa.setStateFinal(4);
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addSymbol('c');
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'b', 2);
+  fa.addTransition(1, 'c', 3);
+  fa.addTransition(2, 'c', 4);
+  fa.addTransition(3, 'a', 3);
+  fa.addTransition(3, 'b', 4);
+  fa.addTransition(4, 'c', 0);
+
+  const fa::CompiledAutomaton compiled(fa);
+  const fa::CompressedAutomaton compressed(compiled);
+  EXPECT_EQ(compressed.countStates(), compiled.countStates());
+  EXPECT_EQ(compressed.getInitialState(), compiled.getInitialState());
+  for (std::uint32_t state = 0; state < compiled.countStates(); ++state) {
+    EXPECT_EQ(compressed.isStateFinal(state), compiled.isStateFinal(state));
+    for (const char symbol : {'a', 'b', 'c', 'd', '\0'}) {
+      EXPECT_EQ(compressed.next(state, symbol), compiled.next(state, symbol));
+    }
+  }
+  for (const char* word : {"", "ac", "bc", "acab", "acabcac", "acc", "bcca", "d"}) {
+    EXPECT_EQ(compressed.match(word), fa.match(word)) << word;
+  }
+}
+TEST(CompressedAutomatonTest, emptyLanguage) {
+  fa::Automaton fa;
+  fa.addState(0);
+  fa.addSymbol('a');
+  const fa::CompressedAutomaton compressed(fa);
+  EXPECT_EQ(compressed.countStates(), 1u);
+  EXPECT_FALSE(compressed.match(""));
+  EXPECT_FALSE(compressed.match("a"));
+}
+TEST(CompressedAutomatonTest, smallerThanDenseTable) {
+  // Keyword automaton over a large alphabet: almost every transition leads to the sink
+  fa::Automaton fa;
+  for (char symbol = 'a'; symbol <= 'z'; ++symbol) {
+    fa.addSymbol(symbol);
+  }
+  fa.addState(0);
+  fa.setStateInitial(0);
+  const std::string keyword = "abcdefghijklmnopqrstuvwxyzzyxwvutsrqponmlkjihgfedcba";
+  for (std::size_t i = 0; i < keyword.size(); ++i) {
+    fa.addState(static_cast<int>(i + 1));
+    fa.addTransition(static_cast<int>(i), keyword[i], static_cast<int>(i + 1));
+  }
+  fa.setStateFinal(static_cast<int>(keyword.size()));
+  fa.complete();
+
+  const fa::CompiledAutomaton compiled(fa);
+  const fa::CompressedAutomaton compressed(compiled);
+  // Compare with a quarter of a dense table using the same 32-bit entries
+  EXPECT_LT(compressed.getTableSize(), compiled.countStates() * compiled.countColumns());
+  EXPECT_TRUE(compressed.match(keyword));
+  EXPECT_FALSE(compressed.match(keyword + "a"));
+  EXPECT_FALSE(compressed.match(keyword.substr(1)));
+}
+
+
+// Tests for StaticAutomaton
+namespace {
+  // Binary numbers divisible by 3
+  constexpr fa::StaticTransition DivisibleBy3Transitions[] = {
+    { 0, '0', 0 }, { 0, '1', 1 },
+    { 1, '0', 2 }, { 1, '1', 0 },
+    { 2, '0', 1 }, { 2, '1', 2 },
+  };
+  constexpr fa::StaticAutomaton<3> DivisibleBy3(DivisibleBy3Transitions, 0, { 0 });
+
+  static_assert(DivisibleBy3.isDeterministic(), "a single transition per state and symbol");
+  static_assert(DivisibleBy3.isComplete(), "every state has both symbols");
+  static_assert(DivisibleBy3.countTransitions() == 6, "no transition is ignored");
+  static_assert(DivisibleBy3.match("") && DivisibleBy3.match("110") && DivisibleBy3.match("1001"), "0, 6 and 9");
+  static_assert(!DivisibleBy3.match("101") && !DivisibleBy3.match("12"), "5 and an invalid digit");
+}
+TEST(StaticAutomatonTest, sameLanguage) {
+  const fa::Automaton fa = DivisibleBy3.toAutomaton();
+  EXPECT_EQ(fa.countStates(), 3u);
+  EXPECT_EQ(fa.countTransitions(), 6u);
+  for (unsigned value = 0; value < 64; ++value) {
+    std::string word;
+    for (unsigned bits = value; bits != 0; bits /= 2) {
+      word.insert(word.begin(), static_cast<char>('0' + bits % 2));
+    }
+    EXPECT_EQ(DivisibleBy3.match(word), value % 3 == 0) << word;
+    EXPECT_EQ(fa.match(word), DivisibleBy3.match(word)) << word;
+  }
+}
+TEST(StaticAutomatonTest, properties) {
+  constexpr fa::StaticAutomaton<2> partial({ { 0, 'a', 1 }, { 1, 'b', 1 } }, 0, { 1 });
+  static_assert(partial.isDeterministic(), "deterministic");
+  static_assert(!partial.isComplete(), "missing transitions");
+  static_assert(partial.match("abbb") && !partial.match("ba"), "ab*");
+
+  constexpr fa::StaticAutomaton<2> nondeterministic({ { 0, 'a', 0 }, { 0, 'a', 1 }, { 0, 'a', 1 } }, 0, { 1 });
+  static_assert(!nondeterministic.isDeterministic(), "two targets for a");
+  static_assert(nondeterministic.countTransitions() == 1, "only the first target is kept");
+  static_assert(nondeterministic.next(0, 'a') == 0 && !nondeterministic.match("a"), "follows the first target");
+
+  constexpr fa::StaticAutomaton<2> invalid({ { 0, 'a', 2 }, { -1, 'a', 0 }, { 0, ' ', 1 }, { 0, 'b', 1 } }, 0, { 1, 5 });
+  EXPECT_EQ(invalid.countTransitions(), 1u);
+  EXPECT_EQ(invalid.next(0, 'a'), -1);
+  EXPECT_EQ(invalid.next(0, 'b'), 1);
+  EXPECT_TRUE(invalid.isStateFinal(1));
+  EXPECT_FALSE(invalid.isStateFinal(5));
+
+  constexpr fa::StaticAutomaton<1> noInitial({ { 0, 'a', 0 } }, 3, { 0 });
+  static_assert(!noInitial.isDeterministic() && !noInitial.match(""), "no initial state");
+}
+
+
+// Tests for generateCpp()
+namespace {
+  std::size_t countOccurrences(const std::string& text, const std::string& pattern) {
+    std::size_t count = 0;
+    for (std::size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+      ++count;
+    }
+    return count;
+  }
+
+  // Words over {a, '} ending with ', with two equivalent final states
+  fa::Automaton createEndsWithQuote() {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('\'');
+    fa.addState(0);
+    fa.addState(1);
+    fa.addState(2);
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+    fa.setStateFinal(2);
+    fa.addTransition(0, 'a', 0);
+    fa.addTransition(0, '\'', 1);
+    fa.addTransition(0, '\'', 2);
+    fa.addTransition(1, 'a', 0);
+    fa.addTransition(1, '\'', 1);
+    fa.addTransition(2, 'a', 0);
+    fa.addTransition(2, '\'', 2);
+    return fa;
+  }
+}
+TEST(AutomatonGenerateCppTest, gotoStyle) {
+  const fa::Automaton fa = createEndsWithQuote();
+  fa::CppGeneratorOptions options;
+  options.functionName = "endsWithQuote";
+  std::ostringstream os;
+  fa.generateCpp(os, options);
+  const std::string code = os.str();
+  EXPECT_NE(code.find("bool endsWithQuote(std::string_view word) {"), std::string::npos);
+  // The two final states are merged
+  EXPECT_EQ(countOccurrences(code, "\nstate"), 2u);
+  EXPECT_EQ(countOccurrences(code, "case '\\''"), 2u);
+  EXPECT_EQ(countOccurrences(code, "return true;"), 1u);
+}
+TEST(AutomatonGenerateCppTest, tableStyle) {
+  const fa::Automaton fa = createRandomAutomaton(5, "ab", 12, 3);
+  fa::CppGeneratorOptions options;
+  options.style = fa::CppGeneratorOptions::Style::Table;
+  std::ostringstream os;
+  fa.generateCpp(os, options);
+  const std::string code = os.str();
+  const fa::CompiledAutomaton compiled(fa::Automaton::createMinimalMoore(fa));
+  EXPECT_NE(code.find("bool match(std::string_view word) {"), std::string::npos);
+  EXPECT_NE(code.find("transitions[" + std::to_string(compiled.countStates()) + "][3]"), std::string::npos);
+  EXPECT_EQ(code.find("goto"), std::string::npos);
+}
+TEST(AutomatonGenerateCppTest, compiledOutput) {
+  // testfa_generated.h holds the output for these automata, compiled into the tests
+  const fa::Automaton quote = createEndsWithQuote();
+  const fa::Automaton random = createRandomAutomaton(6, "abc", 16, 11);
+
+  std::ostringstream os;
+  fa::CppGeneratorOptions options;
+  options.functionName = "generatedEndsWithQuote";
+  quote.generateCpp(os, options);
+  options.functionName = "generatedRandomGoto";
+  random.generateCpp(os, options);
+  options.functionName = "generatedRandomTable";
+  options.style = fa::CppGeneratorOptions::Style::Table;
+  random.generateCpp(os, options);
+
+  std::ifstream file(FA_SOURCE_DIR "/testfa_generated.h");
+  ASSERT_TRUE(file.is_open());
+  std::ostringstream content;
+  content << file.rdbuf();
+  const std::string fixture = content.str();
+  const std::string opening = "#define TESTFA_GENERATED_H\n\n";
+  const std::size_t begin = fixture.find(opening) + opening.size();
+  EXPECT_EQ(fixture.substr(begin, fixture.rfind("\n#endif") - begin), os.str());
+
+  // The compiled functions accept the same words as the automata, with a byte that is not a symbol
+  std::vector<std::string> level = { "" };
+  for (int length = 0; length <= 6; ++length) {
+    std::vector<std::string> next;
+    for (const std::string& word : level) {
+      EXPECT_EQ(generatedEndsWithQuote(word), quote.match(word)) << word;
+      EXPECT_EQ(generatedRandomGoto(word), random.match(word)) << word;
+      EXPECT_EQ(generatedRandomTable(word), random.match(word)) << word;
+      for (const char symbol : std::string("abc'")) {
+        next.push_back(word + symbol);
+      }
+    }
+    level = std::move(next);
+  }
+}
+TEST(AutomatonGenerateCppTest, emptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  std::ostringstream os;
+  fa.generateCpp(os);
+  EXPECT_NE(os.str().find("return false;"), std::string::npos);
+  EXPECT_EQ(os.str().find("state1"), std::string::npos);
+}
+
+
+// Tests for Snapshot
+TEST(SnapshotTest, ownsItsAutomaton) {
+  std::shared_ptr<const fa::Snapshot> snapshot;
+  {
+    CountingResource resource;
+    fa::Automaton fa(&resource);
+    fa.addSymbol('a');
+    fa.addState(0);
+    fa.addState(1);
+    fa.setStateInitial(0);
+    fa.setStateFinal(1);
+    fa.addTransition(0, 'a', 1);
+    snapshot = fa::Snapshot::create(fa);
+    const std::size_t allocations = resource.allocations;
+    fa.addTransition(1, 'a', 1);
+    EXPECT_TRUE(snapshot->match("a"));
+    EXPECT_FALSE(snapshot->match("aa"));
+    EXPECT_EQ(snapshot->getAutomaton().countTransitions(), 1u);
+    EXPECT_NE(snapshot->getAutomaton().getMemoryResource(), &resource);
+    EXPECT_GT(resource.allocations, allocations);
+  }
+  EXPECT_TRUE(snapshot->getAutomaton().match("a"));
+  EXPECT_EQ(snapshot->find("bba"), 2u);
+}
+TEST(SnapshotTest, slot) {
+  fa::SnapshotSlot slot;
+  EXPECT_EQ(slot.load(), nullptr);
+  const std::shared_ptr<const fa::Snapshot> first = fa::Snapshot::create(createChain(1));
+  slot.store(first);
+  EXPECT_EQ(slot.load(), first);
+  slot.store(fa::Snapshot::create(createChain(2)));
+  EXPECT_TRUE(first->match("a"));
+  EXPECT_TRUE(slot.load()->match("aa"));
+}
+TEST(SnapshotTest, concurrentReaders) {
+  // Version i accepts the words of i letters
+  fa::SnapshotSlot slot(fa::Snapshot::create(createChain(1)));
+  std::vector<std::thread> readers;
+  std::vector<int> inconsistencies(4, 0);
+  for (std::size_t i = 0; i < inconsistencies.size(); ++i) {
+    readers.emplace_back([&slot, &inconsistencies, i]() {
+      std::size_t length = 1;
+      while (length < 20) {
+        const std::shared_ptr<const fa::Snapshot> snapshot = slot.load();
+        while (!snapshot->match(std::string(length, 'a'))) {
+          if (++length > 20) {
+            ++inconsistencies[i];
+            return;
+          }
+        }
+        // A snapshot never changes while it is held
+        if (!snapshot->match(std::string(length, 'a')) || snapshot->getAutomaton().countStates() != length + 1) {
+          ++inconsistencies[i];
+        }
+      }
+    });
+  }
+  for (int length = 2; length <= 20; ++length) {
+    slot.store(fa::Snapshot::create(createChain(length)));
+  }
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  for (int count : inconsistencies) {
+    EXPECT_EQ(count, 0);
+  }
+}
+
+
+// Tests for updateMinimal()
+TEST(AutomatonUpdateMinimalTest, mergeStates) {
+  // Words ending with a
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'b', 0);
+  fa.addTransition(1, 'a', 1);
+  fa.addTransition(1, 'b', 0);
+  EXPECT_TRUE(fa.updateMinimal({ { fa::Automaton::Edit::Kind::SetFinal, 0, 'a', 0 } }));
+  EXPECT_EQ(fa.countStates(), 1u);
+  EXPECT_TRUE(fa.isStateInitial(0));
+  EXPECT_TRUE(fa.match(""));
+  EXPECT_TRUE(fa.match("abb"));
+}
+TEST(AutomatonUpdateMinimalTest, removeTransition) {
+  // (a|b)*
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 0);
+  EXPECT_TRUE(fa.updateMinimal({ { fa::Automaton::Edit::Kind::RemoveTransition, 0, 'a', 0 } }));
+  EXPECT_EQ(fa.countStates(), 2u);
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_TRUE(fa.match("bb"));
+  EXPECT_FALSE(fa.match("ba"));
+
+  // The sink state is reused
+  EXPECT_TRUE(fa.updateMinimal({ { fa::Automaton::Edit::Kind::RemoveTransition, 0, 'b', 0 } }));
+  EXPECT_EQ(fa.countStates(), 2u);
+  EXPECT_TRUE(fa.match(""));
+  EXPECT_FALSE(fa.match("b"));
+}
+TEST(AutomatonUpdateMinimalTest, invalidEdit) {
+  fa::Automaton fa = fa::Automaton::createMinimalMoore(createChain(3));
+  const fa::Automaton copy = fa;
+  EXPECT_FALSE(fa.updateMinimal({ { fa::Automaton::Edit::Kind::SetFinal, 0, 'a', 0 }, { fa::Automaton::Edit::Kind::AddTransition, 0, 'z', 1 } }));
+  EXPECT_FALSE(fa.updateMinimal({ { fa::Automaton::Edit::Kind::AddTransition, 0, 'a', 42 } }));
+  expectSameAutomaton(fa, copy, "a");
+}
+TEST(AutomatonUpdateMinimalTest, sameAsMinimalMoore) {
+  using Kind = fa::Automaton::Edit::Kind;
+  for (unsigned seed = 0; seed < 100; ++seed) {
+    const fa::Automaton minimal = fa::Automaton::createMinimalMoore(createRandomAutomaton(6, "abc", 15, seed));
+    std::vector<int> ids;
+    for (int state = 0; ids.size() < minimal.countStates(); ++state) {
+      if (minimal.hasState(state)) {
+        ids.push_back(state);
+      }
+    }
+
+    unsigned random = seed;
+    auto draw = [&random](std::size_t bound) {
+      random = random * 1103515245u + 12345u;
+      return static_cast<std::size_t>((random >> 16) % bound);
+    };
+    std::vector<fa::Automaton::Edit> edits;
+    for (std::size_t i = 1 + draw(4); i > 0; --i) {
+      edits.push_back({ static_cast<Kind>(draw(4)), ids[draw(ids.size())], "abc"[draw(3)], ids[draw(ids.size())] });
+    }
+
+    // The same edits, applied on a copy rebuilt from scratch
+    fa::Automaton edited;
+    for (const char symbol : std::string("abc")) {
+      edited.addSymbol(symbol);
+    }
+    for (const int state : ids) {
+      edited.addState(state);
+      if (minimal.isStateInitial(state)) {
+        edited.setStateInitial(state);
+      }
+    }
+    for (const int state : ids) {
+      bool final = minimal.isStateFinal(state);
+      for (const fa::Automaton::Edit& edit : edits) {
+        if (edit.from == state && (edit.kind == Kind::SetFinal || edit.kind == Kind::SetNonFinal)) {
+          final = edit.kind == Kind::SetFinal;
+        }
+      }
+      if (final) {
+        edited.setStateFinal(state);
+      }
+      for (const char symbol : std::string("abc")) {
+        int target = *minimal.makeTransition({ state }, symbol).begin();
+        for (const fa::Automaton::Edit& edit : edits) {
+          if (edit.from == state && edit.symbol == symbol && edit.kind == Kind::AddTransition) {
+            target = edit.to;
+          } else if (edit.from == state && edit.symbol == symbol && edit.kind == Kind::RemoveTransition) {
+            target = -1;
+          }
+        }
+        if (target != -1) {
+          edited.addTransition(state, symbol, target);
+        }
+      }
+    }
+    const fa::Automaton expected = fa::Automaton::createMinimalMoore(edited);
+
+    fa::Automaton updated = minimal;
+    ASSERT_TRUE(updated.updateMinimal(edits));
+    EXPECT_EQ(updated.countStates(), expected.countStates()) << seed;
+    EXPECT_TRUE(updated.isDeterministic());
+    EXPECT_TRUE(updated.isComplete());
+    EXPECT_TRUE(updated.isIncludedIn(expected)) << seed;
+    EXPECT_TRUE(expected.isIncludedIn(updated)) << seed;
+  }
+}
+
+
+// Tests for WordListBuilder and createFromSortedWords()
+namespace {
+  fa::Automaton createTrie(const std::vector<std::string>& words) {
+    fa::Automaton fa;
+    fa.addState(0);
+    fa.setStateInitial(0);
+    int states = 1;
+    for (const std::string& word : words) {
+      int state = 0;
+      for (const char symbol : word) {
+        fa.addSymbol(symbol);
+        const std::set<int> next = fa.makeTransition({ state }, symbol);
+        if (next.empty()) {
+          fa.addState(states);
+          fa.addTransition(state, symbol, states);
+          state = states++;
+        } else {
+          state = *next.begin();
+        }
+      }
+      fa.setStateFinal(state);
+    }
+    return fa;
+  }
+}
+TEST(AutomatonWordListTest, sharedSuffixes) {
+  const std::vector<std::string> words = { "tap", "taps", "top", "tops" };
+  const fa::Automaton fa = *fa::Automaton::createFromSortedWords(words);
+  // t, a|o, p, s and the final state after s
+  EXPECT_EQ(fa.countStates(), 5u);
+  EXPECT_EQ(fa.countTransitions(), 5u);
+  EXPECT_TRUE(fa.isDeterministic());
+  for (const std::string& word : words) {
+    EXPECT_TRUE(fa.match(word)) << word;
+  }
+  EXPECT_FALSE(fa.match("ta"));
+  EXPECT_FALSE(fa.match("tapss"));
+  EXPECT_FALSE(fa.match(""));
+}
+TEST(AutomatonWordListTest, builder) {
+  fa::Automaton::WordListBuilder builder;
+  EXPECT_TRUE(builder.add(""));
+  EXPECT_TRUE(builder.add("ab"));
+  EXPECT_TRUE(builder.add("ab"));
+  EXPECT_FALSE(builder.add("aa"));
+  EXPECT_FALSE(builder.add("b c"));
+  EXPECT_TRUE(builder.add("b"));
+  const fa::Automaton fa = builder.build();
+  EXPECT_TRUE(fa.match(""));
+  EXPECT_TRUE(fa.match("ab"));
+  EXPECT_TRUE(fa.match("b"));
+  EXPECT_FALSE(fa.match("aa"));
+  EXPECT_FALSE(fa.match("a"));
+  EXPECT_EQ(fa.countStates(), 3u);
+
+  // The builder starts a new list
+  EXPECT_TRUE(builder.add("aa"));
+  const fa::Automaton other = builder.build();
+  EXPECT_TRUE(other.match("aa"));
+  EXPECT_FALSE(other.match("ab"));
+}
+TEST(AutomatonWordListTest, unsortedWords) {
+  EXPECT_FALSE(fa::Automaton::createFromSortedWords({ "b", "a" }));
+  EXPECT_FALSE(fa::Automaton::createFromSortedWords({ "a", "b c" }));
+  EXPECT_TRUE(fa::Automaton::createFromSortedWords({ "a", "a", "b" }));
+}
+TEST(AutomatonWordListTest, fromStream) {
+  std::istringstream input("bar baz foo");
+  const std::optional<fa::Automaton> fa = fa::Automaton::createFromSortedWords(std::istream_iterator<std::string>(input), std::istream_iterator<std::string>());
+  ASSERT_TRUE(fa);
+  EXPECT_TRUE(fa->match("baz"));
+  EXPECT_TRUE(fa->match("foo"));
+  EXPECT_FALSE(fa->match("ba"));
+
+  std::istringstream unsorted("foo bar");
+  EXPECT_FALSE(fa::Automaton::createFromSortedWords(std::istream_iterator<std::string>(unsorted), std::istream_iterator<std::string>()));
+}
+TEST(AutomatonWordListTest, sameAsMinimalMoore) {
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    std::vector<std::string> words;
+    unsigned random = seed;
+    for (int i = 0; i < 200; ++i) {
+      std::string word;
+      random = random * 1103515245u + 12345u;
+      for (std::size_t length = (random >> 16) % 8; length > 0; --length) {
+        random = random * 1103515245u + 12345u;
+        word.push_back("abc"[(random >> 16) % 3]);
+      }
+      words.push_back(word);
+    }
+
+    const fa::Automaton minimal = fa::Automaton::createMinimalMoore(createTrie(words));
+    // With duplicates
+    std::sort(words.begin(), words.end());
+    const fa::Automaton fa = *fa::Automaton::createFromSortedWords(words);
+    // The minimal complete automaton has a sink state
+    EXPECT_EQ(fa.countStates() + 1, minimal.countStates()) << seed;
+    EXPECT_TRUE(fa.isIncludedIn(minimal)) << seed;
+    EXPECT_TRUE(minimal.isIncludedIn(fa)) << seed;
+  }
+}
+
+
+// Tests for shortestWord(), findCommonWord() and findNotIncludedWord()
+namespace {
+  // The first word of at most 6 symbols, in length then alphabetical order, satisfying a predicate
+  template<typename Predicate>
+  std::optional<std::string> findFirstWord(const std::string& symbols, Predicate predicate) {
+    std::vector<std::string> level = { "" };
+    for (int length = 0; length <= 6; ++length) {
+      std::vector<std::string> next;
+      for (const std::string& word : level) {
+        if (predicate(word)) {
+          return word;
+        }
+        for (const char symbol : symbols) {
+          next.push_back(word + symbol);
+        }
+      }
+      level = std::move(next);
+    }
+    return std::nullopt;
+  }
+}
+TEST(AutomatonWitnessTest, shortestWord) {
+  fa::Automaton fa = createChain(3);
+  EXPECT_EQ(fa.shortestWord(), "aaa");
+  fa.addSymbol('b');
+  fa.addTransition(0, 'b', 3);
+  EXPECT_EQ(fa.shortestWord(), "b");
+
+  fa::Automaton empty;
+  empty.addSymbol('a');
+  empty.addState(0);
+  empty.setStateInitial(0);
+  EXPECT_EQ(empty.shortestWord(), std::nullopt);
+  empty.setStateFinal(0);
+  EXPECT_EQ(empty.shortestWord(), "");
+}
+TEST(AutomatonWitnessTest, sameAsEnumeration) {
+  for (unsigned seed = 0; seed < 40; ++seed) {
+    const fa::Automaton lhs = createRandomAutomaton(5, "ab", 8, seed);
+    const fa::Automaton rhs = createRandomAutomaton(4, "ab", 8, seed + 100);
+    auto expectSameLength = [seed](const std::optional<std::string>& witness, const std::optional<std::string>& expected) {
+      ASSERT_EQ(witness.has_value(), expected.has_value()) << seed;
+      if (witness) {
+        EXPECT_EQ(witness->size(), expected->size()) << seed;
+      }
+    };
+
+    // The random automata have no word longer than 6 symbols without a shorter one
+    const std::optional<std::string> word = lhs.shortestWord();
+    expectSameLength(word, findFirstWord("ab", [&](const std::string& candidate) {
+      return lhs.match(candidate);
+    }));
+    EXPECT_TRUE(!word || lhs.match(*word)) << seed;
+    EXPECT_EQ(word.has_value(), !lhs.isLanguageEmpty()) << seed;
+
+    const std::optional<std::string> common = lhs.findCommonWord(rhs);
+    expectSameLength(common, findFirstWord("ab", [&](const std::string& candidate) {
+      return lhs.match(candidate) && rhs.match(candidate);
+    }));
+    EXPECT_TRUE(!common || (lhs.match(*common) && rhs.match(*common))) << seed;
+
+    const std::optional<std::string> notIncluded = lhs.findNotIncludedWord(rhs);
+    expectSameLength(notIncluded, findFirstWord("ab", [&](const std::string& candidate) {
+      return lhs.match(candidate) && !rhs.match(candidate);
+    }));
+    EXPECT_TRUE(!notIncluded || (lhs.match(*notIncluded) && !rhs.match(*notIncluded))) << seed;
+    EXPECT_EQ(notIncluded.has_value(), !lhs.isIncludedIn(rhs)) << seed;
+
+    // The deterministic automaton gives the smallest word in alphabetical order
+    const fa::Automaton deterministic = fa::Automaton::createDeterministic(lhs);
+    EXPECT_EQ(deterministic.shortestWord(), findFirstWord("ab", [&](const std::string& candidate) {
+      return lhs.match(candidate);
+    })) << seed;
+  }
+}
+TEST(AutomatonWitnessTest, otherAlphabet) {
+  fa::Automaton fa = createChain(2);
+  fa::Automaton other;
+  other.addSymbol('b');
+  other.addState(0);
+  other.setStateInitial(0);
+  other.setStateFinal(0);
+  EXPECT_EQ(fa.findCommonWord(other), std::nullopt);
+  EXPECT_EQ(fa.findNotIncludedWord(other), "aa");
+  EXPECT_EQ(other.findNotIncludedWord(fa), "");
+}
+
+
+// Tests for countWords() and countWordsUpTo()
+namespace {
+  // Words over {a, b} without two consecutive b, counted by the Fibonacci numbers
+  fa::Automaton createNoDoubleB() {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('b');
+    fa.addState(0);
+    fa.addState(1);
+    fa.setStateInitial(0);
+    fa.setStateFinal(0);
+    fa.setStateFinal(1);
+    fa.addTransition(0, 'a', 0);
+    fa.addTransition(0, 'b', 1);
+    fa.addTransition(1, 'a', 0);
+    return fa;
+  }
+}
+TEST(AutomatonCountWordsTest, sameAsEnumeration) {
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(5, "ab", 10, seed);
+    std::vector<std::string> words = { "" };
+    std::size_t upTo = 0;
+    for (std::size_t length = 0; length <= 8; ++length) {
+      std::size_t count = 0;
+      std::vector<std::string> next;
+      for (const std::string& word : words) {
+        count += fa.match(word) ? 1 : 0;
+        next.push_back(word + 'a');
+        next.push_back(word + 'b');
+      }
+      upTo += count;
+      EXPECT_EQ(fa.countWords(length), std::to_string(count)) << seed << " " << length;
+      EXPECT_EQ(fa.countWords(length, 7), count % 7) << seed << " " << length;
+      EXPECT_EQ(fa.countWordsUpTo(length), std::to_string(upTo)) << seed << " " << length;
+      EXPECT_EQ(fa.countWordsUpTo(length, 0), upTo) << seed << " " << length;
+      words = std::move(next);
+    }
+  }
+}
+TEST(AutomatonCountWordsTest, exactBigCount) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 0);
+  EXPECT_EQ(fa.countWords(100), "1267650600228229401496703205376");
+  EXPECT_EQ(fa.countWordsUpTo(100), "2535301200456458802993406410751");
+  // 2^64 wraps around
+  EXPECT_EQ(fa.countWords(64, 0), 0u);
+  EXPECT_EQ(fa.countWords(63, 0), std::uint64_t(1) << 63);
+  EXPECT_EQ(createChain(3).countWords(2), "0");
+}
+TEST(AutomatonCountWordsTest, longWordsModulo) {
+  const fa::Automaton fa = createNoDoubleB();
+  const std::uint64_t modulus = 1000000007;
+  // The words of length n are counted by F(n + 2), with F(0) = 0 and F(1) = 1
+  std::uint64_t previous = 0;
+  std::uint64_t current = 1;
+  std::uint64_t sum = 0;
+  const std::size_t length = 100000;
+  for (std::size_t n = 0; n <= length; ++n) {
+    const std::uint64_t next = (previous + current) % modulus;
+    previous = current;
+    current = next;
+    sum = (sum + current) % modulus;
+  }
+  EXPECT_EQ(fa.countWords(length, modulus), current);
+  EXPECT_EQ(fa.countWordsUpTo(length, modulus), sum);
+  EXPECT_EQ(fa.countWords(20), "17711");
+  EXPECT_EQ(fa.countWords(20, modulus), 17711u);
+  // The Pisano period of 10 is 60
+  EXPECT_EQ(fa.countWords(std::size_t(60) * 1000000000 - 2, 10), 0u);
+}
+
+
+// Tests for WordSampler
+namespace {
+  // aaa or b followed by two symbols: a random walk would draw aaa half of the time
+  fa::Automaton createSkewedLanguage() {
+    fa::Automaton fa;
+    fa.addSymbol('a');
+    fa.addSymbol('b');
+    for (int i = 0; i < 6; ++i) {
+      fa.addState(i);
+    }
+    fa.setStateInitial(0);
+    fa.setStateFinal(5);
+    fa.addTransition(0, 'a', 1);
+    fa.addTransition(1, 'a', 2);
+    fa.addTransition(2, 'a', 5);
+    fa.addTransition(0, 'b', 3);
+    fa.addTransition(3, 'a', 4);
+    fa.addTransition(3, 'b', 4);
+    fa.addTransition(4, 'a', 5);
+    fa.addTransition(4, 'b', 5);
+    return fa;
+  }
+}
+TEST(WordSamplerTest, uniform) {
+  const fa::WordSampler sampler(createSkewedLanguage(), 3);
+  EXPECT_FALSE(sampler.isEmpty());
+  EXPECT_EQ(sampler.getLength(), 3u);
+  std::mt19937_64 generator(42);
+  std::map<std::string, int> counts;
+  for (int i = 0; i < 10000; ++i) {
+    ++counts[sampler.sample(generator)];
+  }
+  EXPECT_EQ(counts.size(), 5u);
+  for (const auto& count : counts) {
+    EXPECT_GT(count.second, 1700) << count.first;
+    EXPECT_LT(count.second, 2300) << count.first;
+  }
+}
+TEST(WordSamplerTest, empty) {
+  EXPECT_TRUE(fa::WordSampler(createSkewedLanguage(), 2).isEmpty());
+  EXPECT_TRUE(fa::WordSampler(createSkewedLanguage(), 4).isEmpty());
+  const fa::WordSampler chain(createChain(0), 0);
+  EXPECT_FALSE(chain.isEmpty());
+  std::mt19937_64 generator(1);
+  EXPECT_EQ(chain.sample(generator), "");
+}
+TEST(WordSamplerTest, batch) {
+  std::size_t tested = 0;
+  for (unsigned seed = 0; seed < 10; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(5, "abc", 15, seed);
+    const fa::WordSampler sampler(fa, 30);
+    if (sampler.isEmpty()) {
+      continue;
+    }
+    ++tested;
+    const std::vector<std::string> words = sampler.sampleBatch(100, seed, 3);
+    ASSERT_EQ(words.size(), 100u);
+    for (const std::string& word : words) {
+      EXPECT_EQ(word.size(), 30u);
+      EXPECT_TRUE(fa.match(word)) << word;
+    }
+    EXPECT_EQ(sampler.sampleBatch(100, seed, 3), words);
+    EXPECT_EQ(sampler.sampleBatch(2, seed, 8).size(), 2u);
+  }
+  EXPECT_GE(tested, 3u);
+}
+TEST(WordSamplerTest, longFixedPrefix) {
+  // 1100 a then any word: the counts of the states of the prefix are far below the one of the last state
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for (int i = 0; i <= 1100; ++i) {
+    fa.addState(i);
+  }
+  for (int i = 0; i < 1100; ++i) {
+    fa.addTransition(i, 'a', i + 1);
+  }
+  fa.addTransition(1100, 'a', 1100);
+  fa.addTransition(1100, 'b', 1100);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1100);
+  ASSERT_NE(fa.countWords(2210, 1000000007), 0u);
+
+  const fa::WordSampler sampler(fa, 2210);
+  EXPECT_FALSE(sampler.isEmpty());
+  std::mt19937_64 generator(3);
+  for (int i = 0; i < 10; ++i) {
+    const std::string word = sampler.sample(generator);
+    EXPECT_EQ(word.size(), 2210u);
+    EXPECT_EQ(word.find_first_not_of('a'), word.find('b'));
+    EXPECT_GE(word.find('b'), 1100u);
+    EXPECT_TRUE(fa.match(word));
+  }
+  EXPECT_TRUE(fa::WordSampler(fa, 1099).isEmpty());
+}
+
+
+// Tests for WordEnumerator
+TEST(WordEnumeratorTest, finiteLanguage) {
+  const fa::Automaton fa = *fa::Automaton::createFromSortedWords({ "aa", "ab", "abc", "b", "c" });
+  fa::WordEnumerator enumerator(fa);
+  std::vector<std::string> words;
+  for (const std::string_view word : enumerator) {
+    words.emplace_back(word);
+  }
+  EXPECT_EQ(words, std::vector<std::string>({ "b", "c", "aa", "ab", "abc" }));
+  EXPECT_FALSE(enumerator.next());
+}
+TEST(WordEnumeratorTest, infiniteLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, 'b', 0);
+  fa::WordEnumerator enumerator(fa);
+  const std::vector<std::string> expected = { "", "a", "b", "aa", "ab", "ba", "bb", "aaa" };
+  for (const std::string& word : expected) {
+    ASSERT_TRUE(enumerator.next());
+    EXPECT_EQ(enumerator.getWord(), word);
+  }
+
+  fa::WordEnumeratorOptions options;
+  options.prefix = "ba";
+  options.maxLength = 3;
+  fa::WordEnumerator prefixed(fa, options);
+  std::vector<std::string> words;
+  for (const std::string_view word : prefixed) {
+    words.emplace_back(word);
+  }
+  EXPECT_EQ(words, std::vector<std::string>({ "ba", "baa", "bab" }));
+
+  options.prefix = "bc";
+  fa::WordEnumerator none(fa, options);
+  EXPECT_FALSE(none.next());
+}
+TEST(WordEnumeratorTest, sameAsEnumeration) {
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(5, "ab", 10, seed);
+    for (const std::string prefix : { "", "a", "ba" }) {
+      std::vector<std::string> expected;
+      std::vector<std::string> level = { "" };
+      for (int length = 0; length <= 6; ++length) {
+        std::vector<std::string> next;
+        for (const std::string& word : level) {
+          if (word.compare(0, prefix.size(), prefix) == 0 && fa.match(word)) {
+            expected.push_back(word);
+          }
+          next.push_back(word + 'a');
+          next.push_back(word + 'b');
+        }
+        level = std::move(next);
+      }
+
+      fa::WordEnumeratorOptions options;
+      options.prefix = prefix;
+      options.maxLength = 6;
+      fa::WordEnumerator enumerator(fa, options);
+      std::vector<std::string> words;
+      while (enumerator.next()) {
+        words.emplace_back(enumerator.getWord());
+      }
+      EXPECT_EQ(words, expected) << seed << " " << prefix;
+    }
+  }
+}
+
+
+// Tests for createLevenshtein() and intersectFuzzy()
+namespace {
+  std::size_t editDistance(const std::string& lhs, const std::string& rhs) {
+    std::vector<std::size_t> row(rhs.size() + 1);
+    for (std::size_t j = 0; j <= rhs.size(); ++j) {
+      row[j] = j;
+    }
+    for (std::size_t i = 1; i <= lhs.size(); ++i) {
+      std::size_t diagonal = row[0];
+      row[0] = i;
+      for (std::size_t j = 1; j <= rhs.size(); ++j) {
+        const std::size_t above = row[j];
+        row[j] = std::min({ row[j] + 1, row[j - 1] + 1, diagonal + (lhs[i - 1] == rhs[j - 1] ? 0 : 1) });
+        diagonal = above;
+      }
+    }
+    return row[rhs.size()];
+  }
+}
+TEST(AutomatonLevenshteinTest, kitten) {
+  const fa::Automaton fa = fa::Automaton::createLevenshtein("kitten", 1, "abcdefghijklmnopqrstuvwxyz");
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.match("kitten"));
+  EXPECT_TRUE(fa.match("sitten"));
+  EXPECT_TRUE(fa.match("kittn"));
+  EXPECT_TRUE(fa.match("kittens"));
+  EXPECT_TRUE(fa.match("kitxten"));
+  EXPECT_FALSE(fa.match("sittin"));
+  EXPECT_FALSE(fa.match("kit"));
+  EXPECT_FALSE(fa.match(""));
+}
+TEST(AutomatonLevenshteinTest, sameAsEditDistance) {
+  for (const std::string word : { "", "a", "abca", "bbab" }) {
+    for (unsigned distance = 0; distance <= 2; ++distance) {
+      const fa::Automaton fa = fa::Automaton::createLevenshtein(word, distance, "abc");
+      std::vector<std::string> level = { "" };
+      for (int length = 0; length <= 6; ++length) {
+        std::vector<std::string> next;
+        for (const std::string& candidate : level) {
+          EXPECT_EQ(fa.match(candidate), editDistance(word, candidate) <= distance) << word << " " << candidate << " " << distance;
+          for (const char symbol : std::string("abc")) {
+            next.push_back(candidate + symbol);
+          }
+        }
+        level = std::move(next);
+      }
+    }
+  }
+}
+TEST(AutomatonLevenshteinTest, linearSize) {
+  std::string word;
+  std::vector<std::size_t> states;
+  for (int repeat = 1; repeat <= 4; ++repeat) {
+    word += "abcdefghij";
+    states.push_back(fa::Automaton::createLevenshtein(word, 2, "").countStates());
+  }
+  // Each block of the word adds the same number of states
+  EXPECT_EQ(states[2] - states[1], states[1] - states[0]);
+  EXPECT_EQ(states[3] - states[2], states[1] - states[0]);
+}
+TEST(AutomatonLevenshteinTest, intersectFuzzy) {
+  const std::vector<std::string> words = { "bat", "bath", "cat", "cats", "dog", "hat", "tab" };
+  const fa::Automaton dictionary = *fa::Automaton::createFromSortedWords(words);
+  EXPECT_EQ(fa::Automaton::intersectFuzzy(dictionary, "bat", 1), std::vector<std::string>({ "bat", "bath", "cat", "hat" }));
+  EXPECT_EQ(fa::Automaton::intersectFuzzy(dictionary, "xyz", 1), std::vector<std::string>());
+  for (unsigned distance = 0; distance <= 3; ++distance) {
+    std::vector<std::string> expected;
+    for (const std::string& word : words) {
+      if (editDistance("cast", word) <= distance) {
+        expected.push_back(word);
+      }
+    }
+    EXPECT_EQ(fa::Automaton::intersectFuzzy(dictionary, "cast", distance), expected) << distance;
+  }
+}
+
+// Tests for createUnion(), createConcatenation() and createKleeneStar()
+namespace {
+  std::vector<std::string> allWords(const std::string& symbols, std::size_t maxLength) {
+    std::vector<std::string> words = { "" };
+    for (std::size_t i = 0; words[i].size() < maxLength; ++i) {
+      for (const char symbol : symbols) {
+        words.push_back(words[i] + symbol);
+      }
+    }
+    return words;
+  }
+
+  bool matchStar(const fa::Automaton& fa, const std::string& word) {
+    std::vector<bool> reachable(word.size() + 1, false);
+    reachable[0] = true;
+    for (std::size_t end = 1; end <= word.size(); ++end) {
+      for (std::size_t begin = 0; begin < end && !reachable[end]; ++begin) {
+        reachable[end] = reachable[begin] && fa.match(word.substr(begin, end - begin));
+      }
+    }
+    return reachable[word.size()];
+  }
+}
+TEST(AutomatonRegularOperationsTest, sparseNumbersAndEpsilon) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addState(10);
+  lhs.addState(3);
+  lhs.setStateInitial(10);
+  lhs.setStateFinal(3);
+  lhs.addTransition(10, 'a', 3);
+  lhs.addTransition(10, fa::Epsilon, 3);
+  fa::Automaton rhs;
+  rhs.addSymbol('b');
+  rhs.addState(7);
+  rhs.setStateInitial(7);
+  rhs.setStateFinal(7);
+  rhs.addTransition(7, 'b', 7);
+
+  const fa::Automaton both = fa::Automaton::createUnion(lhs, rhs);
+  EXPECT_EQ(both.countStates(), 3u);
+  EXPECT_EQ(both.countSymbols(), 2u);
+  EXPECT_FALSE(both.hasEpsilonTransition());
+  EXPECT_TRUE(both.match("a"));
+  EXPECT_TRUE(both.match(""));
+  EXPECT_TRUE(both.match("bbb"));
+  EXPECT_FALSE(both.match("ab"));
+
+  const fa::Automaton concatenation = fa::Automaton::createConcatenation(lhs, rhs);
+  EXPECT_FALSE(concatenation.hasEpsilonTransition());
+  EXPECT_TRUE(concatenation.match("a"));
+  EXPECT_TRUE(concatenation.match("abb"));
+  EXPECT_FALSE(concatenation.match(""));
+  EXPECT_FALSE(concatenation.match("b"));
+
+  const fa::Automaton star = fa::Automaton::createKleeneStar(lhs);
+  EXPECT_FALSE(star.hasEpsilonTransition());
+  EXPECT_TRUE(star.match(""));
+  EXPECT_TRUE(star.match("aaa"));
+  EXPECT_FALSE(star.match("b"));
+}
+TEST(AutomatonRegularOperationsTest, sameAsDefinition) {
+  const std::vector<std::string> words = allWords("ab", 6);
+  for (unsigned seed = 1; seed <= 20; ++seed) {
+    const fa::Automaton lhs = createRandomAutomaton(4, "ab", 7, seed);
+    const fa::Automaton rhs = createRandomAutomaton(3, "ab", 5, seed + 100);
+    const fa::Automaton both = fa::Automaton::createUnion(lhs, rhs);
+    const fa::Automaton concatenation = fa::Automaton::createConcatenation(lhs, rhs);
+    const fa::Automaton star = fa::Automaton::createKleeneStar(lhs);
+    EXPECT_TRUE(both.isValid());
+    EXPECT_EQ(both.countStates(), 7u);
+    EXPECT_EQ(concatenation.countStates(), 7u);
+    EXPECT_EQ(star.countStates(), 5u);
+    for (const std::string& word : words) {
+      EXPECT_EQ(both.match(word), lhs.match(word) || rhs.match(word)) << seed << " " << word;
+      bool split = false;
+      for (std::size_t i = 0; i <= word.size() && !split; ++i) {
+        split = lhs.match(word.substr(0, i)) && rhs.match(word.substr(i));
+      }
+      EXPECT_EQ(concatenation.match(word), split) << seed << " " << word;
+      EXPECT_EQ(star.match(word), matchStar(lhs, word)) << seed << " " << word;
+    }
+  }
+}
+TEST(AutomatonRegularOperationsTest, memoryResource) {
+  CountingResource resource;
+  fa::Automaton lhs(&resource);
+  lhs.addSymbol('a');
+  lhs.addState(0);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(0);
+  lhs.addTransition(0, 'a', 0);
+  const std::size_t before = resource.allocations;
+  const fa::Automaton star = fa::Automaton::createKleeneStar(lhs);
+  EXPECT_EQ(star.getMemoryResource(), &resource);
+  EXPECT_GT(resource.allocations, before);
+}
+// Tests for createIntersection() and hasEmptyIntersection() with several automata
+TEST(AutomatonIntersectionManyTest, sameAsDefinition) {
+  const std::vector<std::string> words = allWords("ab", 7);
+  for (unsigned seed = 1; seed <= 20; ++seed) {
+    const fa::Automaton first = createRandomAutomaton(4, "ab", 9, seed);
+    const fa::Automaton second = createRandomAutomaton(3, "ab", 6, seed + 100);
+    const fa::Automaton third = createRandomAutomaton(5, "abc", 12, seed + 200);
+    const fa::Automaton product = fa::Automaton::createIntersection({ &first, &second, &third });
+    EXPECT_TRUE(product.isValid());
+    EXPECT_FALSE(product.hasSymbol('c'));
+    for (const std::string& word : words) {
+      EXPECT_EQ(product.match(word), first.match(word) && second.match(word) && third.match(word)) << seed << " " << word;
+    }
+    const fa::Automaton chained = fa::Automaton::createIntersection(fa::Automaton::createIntersection(first, second), third);
+    EXPECT_EQ(fa::Automaton::hasEmptyIntersection({ &first, &second, &third }), chained.isLanguageEmpty()) << seed;
+    EXPECT_LE(product.countStates(), chained.countStates()) << seed;
+  }
+}
+TEST(AutomatonIntersectionManyTest, prunesDeadTuples) {
+  // Words with an even number of a, words ending with b and a dead branch that never reaches a final state
+  fa::Automaton even;
+  even.addSymbol('a');
+  even.addSymbol('b');
+  even.addState(0);
+  even.addState(1);
+  even.setStateInitial(0);
+  even.setStateFinal(0);
+  even.addTransition(0, 'a', 1);
+  even.addTransition(1, 'a', 0);
+  even.addTransition(0, 'b', 0);
+  even.addTransition(1, 'b', 1);
+  fa::Automaton endsWithB;
+  endsWithB.addSymbol('a');
+  endsWithB.addSymbol('b');
+  endsWithB.addState(0);
+  endsWithB.addState(1);
+  endsWithB.addState(2);
+  endsWithB.setStateInitial(0);
+  endsWithB.setStateFinal(1);
+  endsWithB.addTransition(0, 'a', 0);
+  endsWithB.addTransition(0, 'b', 0);
+  endsWithB.addTransition(0, 'b', 1);
+  endsWithB.addTransition(0, 'a', 2);
+  endsWithB.addTransition(2, 'a', 2);
+
+  const fa::Automaton product = fa::Automaton::createIntersection({ &even, &endsWithB });
+  // Only (0, 0), (1, 0) and (0, 1) can reach the final tuple (0, 1)
+  EXPECT_EQ(product.countStates(), 3u);
+  EXPECT_GT(fa::Automaton::createIntersection(even, endsWithB).countStates(), 3u);
+  EXPECT_TRUE(product.match("aab"));
+  EXPECT_TRUE(product.match("b"));
+  EXPECT_FALSE(product.match("ab"));
+  EXPECT_FALSE(product.match("aa"));
+
+  fa::Automaton copy = product;
+  copy.removeNonCoAccessibleStates();
+  EXPECT_EQ(copy.countStates(), product.countStates());
+}
+TEST(AutomatonIntersectionManyTest, emptyCases) {
+  const fa::Automaton fa = createRandomAutomaton(4, "ab", 9, 3);
+  EXPECT_TRUE(fa::Automaton::hasEmptyIntersection({}));
+  EXPECT_TRUE(fa::Automaton::createIntersection({}).isLanguageEmpty());
+  EXPECT_EQ(fa::Automaton::hasEmptyIntersection({ &fa }), fa.isLanguageEmpty());
+
+  fa::Automaton onlyC;
+  onlyC.addSymbol('c');
+  onlyC.addState(0);
+  onlyC.setStateInitial(0);
+  onlyC.setStateFinal(0);
+  onlyC.addTransition(0, 'c', 0);
+  const fa::Automaton product = fa::Automaton::createIntersection({ &fa, &onlyC });
+  EXPECT_TRUE(product.isValid());
+  EXPECT_EQ(product.match(""), fa.match(""));
+  EXPECT_FALSE(product.match("c"));
+  EXPECT_EQ(fa::Automaton::hasEmptyIntersection({ &fa, &onlyC }), !fa.match(""));
+}
+TEST(AutomatonIntersectionManyTest, stopsEarly) {
+  // The product of twelve cycles is large, but its initial tuple is already final
+  std::vector<fa::Automaton> cycles;
+  for (int length = 2; length <= 13; ++length) {
+    fa::Automaton cycle;
+    cycle.addSymbol('a');
+    for (int i = 0; i < length; ++i) {
+      cycle.addState(i);
+    }
+    for (int i = 0; i < length; ++i) {
+      cycle.addTransition(i, 'a', (i + 1) % length);
+    }
+    cycle.setStateInitial(0);
+    cycle.setStateFinal(0);
+    cycles.push_back(std::move(cycle));
+  }
+  std::vector<const fa::Automaton*> automata;
+  for (const fa::Automaton& cycle : cycles) {
+    automata.push_back(&cycle);
+  }
+  EXPECT_FALSE(fa::Automaton::hasEmptyIntersection(automata));
+}
+// Tests for reduceBySimulation()
+TEST(AutomatonReduceBySimulationTest, sameLanguage) {
+  const std::vector<std::string> words = allWords("ab", 7);
+  for (unsigned seed = 1; seed <= 40; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(8, "ab", 18, seed);
+    fa::Automaton reduced = fa;
+    reduced.reduceBySimulation();
+    EXPECT_TRUE(reduced.isValid());
+    EXPECT_LE(reduced.countStates(), fa.countStates());
+    EXPECT_LE(reduced.countTransitions(), fa.countTransitions());
+    for (const std::string& word : words) {
+      EXPECT_EQ(reduced.match(word), fa.match(word)) << seed << " " << word;
+    }
+    EXPECT_TRUE(fa.isIncludedIn(reduced) && reduced.isIncludedIn(fa)) << seed;
+  }
+}
+TEST(AutomatonReduceBySimulationTest, mergesCopies) {
+  const fa::Automaton minimal = fa::Automaton::createMinimalMoore(createRandomAutomaton(6, "ab", 14, 5));
+  fa::Automaton both = fa::Automaton::createUnion(minimal, minimal);
+  ASSERT_EQ(both.countStates(), 2 * minimal.countStates());
+  both.reduceBySimulation();
+  EXPECT_EQ(both.countStates(), minimal.countStates());
+  EXPECT_EQ(both.countTransitions(), minimal.countTransitions());
+  EXPECT_TRUE(both.isIncludedIn(minimal) && minimal.isIncludedIn(both));
+}
+TEST(AutomatonReduceBySimulationTest, prunesLittleBrothers) {
+  // After a, state 1 only accepts the end of the word while state 2 also accepts more a
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.addState(3);
+  fa.setStateInitial(0);
+  fa.setStateInitial(3);
+  fa.setStateFinal(1);
+  fa.setStateFinal(2);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'a', 2);
+  fa.addTransition(2, 'a', 2);
+  fa.addTransition(3, 'a', 1);
+  fa.reduceBySimulation();
+  EXPECT_EQ(fa.countStates(), 2u);
+  EXPECT_EQ(fa.countTransitions(), 2u);
+  EXPECT_TRUE(fa.hasTransition(0, 'a', 2));
+  EXPECT_TRUE(fa.hasTransition(2, 'a', 2));
+  EXPECT_TRUE(fa.isStateInitial(0));
+  EXPECT_FALSE(fa.match(""));
+  EXPECT_TRUE(fa.match("aaa"));
+}
+TEST(AutomatonReduceBySimulationTest, emptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(4);
+  fa.addState(7);
+  fa.addTransition(4, 'a', 7);
+  fa.reduceBySimulation();
+  EXPECT_TRUE(fa.isValid());
+  EXPECT_TRUE(fa.isLanguageEmpty());
+  EXPECT_EQ(fa.countStates(), 1u);
+}
+TEST(AutomatonReduceBySimulationTest, beforeDeterminization) {
+  for (unsigned seed = 1; seed <= 20; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(10, "ab", 24, seed);
+    fa::Automaton reduced = fa;
+    reduced.reduceBySimulation();
+    const fa::Automaton deterministic = fa::Automaton::createDeterministic(reduced);
+    EXPECT_EQ(fa::Automaton::createMinimalMoore(deterministic).countStates(), fa::Automaton::createMinimalMoore(fa).countStates()) << seed;
+  }
+}
+// Tests for reduceByBisimulation()
+namespace {
+  std::size_t countBisimulationClasses(const fa::Automaton& fa, int states, const std::string& symbols) {
+    // Naive refinement: split the classes by the classes reached with each symbol until nothing changes
+    std::vector<int> classes(states);
+    for (int state = 0; state < states; ++state) {
+      classes[state] = fa.isStateFinal(state) ? 1 : 0;
+    }
+    std::size_t count = 0;
+    while (true) {
+      std::map<std::pair<int, std::vector<std::set<int>>>, int> signatures;
+      std::vector<int> next(states);
+      for (int state = 0; state < states; ++state) {
+        std::vector<std::set<int>> reached;
+        for (const char symbol : symbols) {
+          std::set<int> targets;
+          for (int to = 0; to < states; ++to) {
+            if (fa.hasTransition(state, symbol, to)) {
+              targets.insert(classes[to]);
+            }
+          }
+          reached.push_back(targets);
+        }
+        next[state] = signatures.emplace(std::make_pair(classes[state], reached), static_cast<int>(signatures.size())).first->second;
+      }
+      classes = next;
+      if (signatures.size() == count) {
+        return count;
+      }
+      count = signatures.size();
+    }
+  }
+}
+TEST(AutomatonReduceByBisimulationTest, sameAsNaiveRefinement) {
+  const std::vector<std::string> words = allWords("ab", 7);
+  for (unsigned seed = 1; seed <= 60; ++seed) {
+    const fa::Automaton fa = createRandomAutomaton(9, "ab", 12 + seed % 10, seed);
+    fa::Automaton reduced = fa;
+    reduced.reduceByBisimulation();
+    EXPECT_TRUE(reduced.isValid());
+    EXPECT_EQ(reduced.countStates(), countBisimulationClasses(fa, 9, "ab")) << seed;
+    for (const std::string& word : words) {
+      EXPECT_EQ(reduced.match(word), fa.match(word)) << seed << " " << word;
+    }
+  }
+}
+TEST(AutomatonReduceByBisimulationTest, completeDeterministic) {
+  for (unsigned seed = 1; seed <= 20; ++seed) {
+    const fa::Automaton deterministic = fa::Automaton::createComplete(fa::Automaton::createDeterministic(createRandomAutomaton(7, "ab", 14, seed)));
+    fa::Automaton reduced = deterministic;
+    reduced.reduceByBisimulation();
+    EXPECT_TRUE(reduced.isDeterministic());
+    EXPECT_EQ(reduced.countStates(), fa::Automaton::createMinimalMoore(deterministic).countStates()) << seed;
+  }
+}
+TEST(AutomatonReduceByBisimulationTest, keepsSimulationOnlyStates) {
+  // State 2 simulates state 1 but not the other way around
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.setStateFinal(2);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(0, 'a', 2);
+  fa.addTransition(2, 'a', 2);
+  fa.reduceByBisimulation();
+  EXPECT_EQ(fa.countStates(), 3u);
+  EXPECT_EQ(fa.countTransitions(), 3u);
+}
+TEST(AutomatonReduceByBisimulationTest, manyCopies) {
+  fa::Automaton cycle;
+  cycle.addSymbol('a');
+  cycle.addSymbol('b');
+  for (int i = 0; i < 6; ++i) {
+    cycle.addState(i);
+  }
+  for (int i = 0; i < 6; ++i) {
+    cycle.addTransition(i, 'a', (i + 1) % 6);
+    cycle.addTransition(i, 'b', (i + 3) % 6);
+  }
+  cycle.setStateInitial(0);
+  cycle.setStateFinal(0);
+  cycle.setStateFinal(3);
+  fa::Automaton copies = cycle;
+  for (int i = 0; i < 9; ++i) {
+    copies = fa::Automaton::createUnion(copies, copies);
+  }
+  ASSERT_EQ(copies.countStates(), 6u * 512);
+  copies.reduceByBisimulation();
+  // 0 and 3 are bisimilar, and so are 1 and 4, 2 and 5
+  EXPECT_EQ(copies.countStates(), 3u);
+  EXPECT_TRUE(copies.isStateInitial(0));
+  EXPECT_TRUE(copies.isIncludedIn(cycle) && cycle.isIncludedIn(copies));
+}
+TEST(AutomatonReduceByBisimulationTest, epsilonAndSparseNumbers) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(5);
+  fa.addState(9);
+  fa.addState(12);
+  fa.setStateInitial(5);
+  fa.setStateFinal(9);
+  fa.setStateFinal(12);
+  fa.addTransition(5, 'a', 9);
+  fa.addTransition(5, 'a', 12);
+  fa.addTransition(5, fa::Epsilon, 9);
+  fa.reduceByBisimulation();
+  EXPECT_EQ(fa.countStates(), 2u);
+  EXPECT_TRUE(fa.hasTransition(5, 'a', 9));
+  EXPECT_TRUE(fa.hasTransition(5, fa::Epsilon, 9));
+  EXPECT_TRUE(fa.match("a"));
+  EXPECT_FALSE(fa.match("aa"));
+}
 
 
 
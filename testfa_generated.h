@@ -0,0 +1,130 @@
+// Output of generateCpp() for the automata of AutomatonGenerateCppTest.compiledOutput
+// The test checks that it is still what generateCpp() prints: regenerate it when the
+// generated code changes.
+#ifndef TESTFA_GENERATED_H
+#define TESTFA_GENERATED_H
+
+#include <string_view>
+
+// Minimal automaton with 2 states
+bool generatedEndsWithQuote(std::string_view word) {
+  const char* current = word.data();
+  const char* end = current + word.size();
+  goto state1;
+state1:
+  if (current == end) {
+    return false;
+  }
+  switch (*current++) {
+    case 'a': goto state1;
+    case '\'': goto state2;
+    default: return false;
+  }
+state2:
+  if (current == end) {
+    return true;
+  }
+  switch (*current++) {
+    case 'a': goto state1;
+    case '\'': goto state2;
+    default: return false;
+  }
+}
+#include <string_view>
+
+// Minimal automaton with 6 states
+bool generatedRandomGoto(std::string_view word) {
+  const char* current = word.data();
+  const char* end = current + word.size();
+  goto state1;
+state1:
+  if (current == end) {
+    return false;
+  }
+  switch (*current++) {
+    case 'c': goto state2;
+    default: return false;
+  }
+state2:
+  if (current == end) {
+    return true;
+  }
+  switch (*current++) {
+    case 'c': goto state2;
+    case 'a': goto state3;
+    case 'b': goto state4;
+    default: return false;
+  }
+state3:
+  if (current == end) {
+    return false;
+  }
+  switch (*current++) {
+    case 'c': goto state3;
+    case 'b': goto state5;
+    default: return false;
+  }
+state4:
+  if (current == end) {
+    return false;
+  }
+  switch (*current++) {
+    case 'c': goto state4;
+    case 'b': goto state6;
+    default: return false;
+  }
+state5:
+  if (current == end) {
+    return true;
+  }
+  switch (*current++) {
+    case 'a': goto state3;
+    case 'c': goto state4;
+    case 'b': goto state5;
+    default: return false;
+  }
+state6:
+  if (current == end) {
+    return true;
+  }
+  switch (*current++) {
+    case 'a': goto state3;
+    case 'b': goto state4;
+    default: return false;
+  }
+}
+#include <string_view>
+
+// Minimal automaton with 6 states
+bool generatedRandomTable(std::string_view word) {
+  static constexpr unsigned char columns[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 2, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  };
+  static constexpr unsigned char transitions[7][4] = {
+    { 0, 0, 0, 0, },
+    { 0, 0, 0, 2, },
+    { 0, 3, 4, 2, },
+    { 0, 0, 5, 3, },
+    { 0, 0, 6, 4, },
+    { 0, 3, 5, 4, },
+    { 0, 3, 4, 0, },
+  };
+  static constexpr bool finals[7] = { false, false, true, false, false, true, true, };
+  unsigned state = 1;
+  for (const char c : word) {
+    state = transitions[state][columns[static_cast<unsigned char>(c)]];
+    if (state == 0) {
+      return false;
+    }
+  }
+  return finals[state];
+}
+
+#endif // TESTFA_GENERATED_H